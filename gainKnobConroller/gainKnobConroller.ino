@@ -16,6 +16,24 @@ int ledValue = 0;
 const byte midiChannel = 0;  // MIDI channels are 0-15 in code (shown as 1-16 to users)
 const byte controllerNumber = 7;  // CC #7 is volume control - widely recognized by DAWs
 
+// Active Sensing interval; the plugin times out after 300 ms of silence
+const unsigned long activeSensingInterval = 100;
+
+// SysEx state handshake with the plugin (see ControllerSysEx.h there):
+//   F0 7D 01 01 F7                        plugin asks for our state
+//   F0 7D 01 02 ch n [cc value]*n F7      we answer with every control
+//   F0 7D 01 03 ch n [cc value]*n F7      plugin pushes its feedback state
+const byte sysexManufacturer = 0x7D;
+const byte sysexProduct = 0x01;
+const byte sysexStateRequest = 0x01;
+const byte sysexStateDump = 0x02;
+const byte sysexFeedbackDump = 0x03;
+
+// Incoming SysEx from USB, reassembled from 3-byte packets
+byte sysexBuffer[72];
+int sysexLength = 0;
+bool sysexOverflow = false;
+
 // Variables to track potentiometer value
 int currentPotValue = 0;
 int lastPotValue = -1;
@@ -56,17 +74,19 @@ void loop() {
 
   if (MIDI.read()) { // Check if a MIDI message is received
     if (MIDI.getType() == midi::ControlChange) { // Check if it's a Control Change message
-      if (MIDI.getData1() == 7) { // Check if it's CC#7
-        int value = MIDI.getData2(); // Get the value (0-127)
-        // Map the MIDI value (0-127) to a PWM value (0-255)
-        int pwmValue = map(value, 0, 127, 0, 255);
-        
-        // Set the LED brightness using PWM
-        analogWrite(ledPin, pwmValue);
-      }
+      handleControlChange(MIDI.getData1(), MIDI.getData2());
     }
   }
 
+  // Feedback and state requests from the plugin arrive over USB
+  midiEventPacket_t rx;
+  do {
+    rx = MidiUSB.read();
+    if (rx.header != 0) {
+      handleUsbPacket(rx);
+    }
+  } while (rx.header != 0);
+
   // write to led
   //analogWrite(pin_red, 255);
   //analogWrite(pin_green, 0);
@@ -116,14 +136,12 @@ void loop() {
     Serial.println(")");
   }
   
-  // Send a refresh message every 2 seconds to ensure connection
-  static unsigned long lastRefreshTime = 0;
-  if (millis() - lastRefreshTime > 2000) {
-    // Send the current value again to refresh
-    sendMidiCC(midiChannel, controllerNumber, midiValue);
-    lastRefreshTime = millis();
-    
-    Serial.println("Sending refresh message");
+  // Send Active Sensing as a heartbeat, so the plugin notices within a few
+  // hundred ms if we stop; the knob value is only sent when it changes
+  static unsigned long lastSensingTime = 0;
+  if (millis() - lastSensingTime >= activeSensingInterval) {
+    sendActiveSensing();
+    lastSensingTime = millis();
   }
   
   // Small delay to stabilize readings and reduce USB bus traffic
@@ -136,6 +154,112 @@ void sendMidiCC(byte channel, byte control, byte value) {
   MidiUSB.sendMIDI(event);
   MidiUSB.flush();
 }
+// Feedback from the plugin: CC#7 sets the LED brightness
+void handleControlChange(byte control, byte value) {
+  if (control == controllerNumber) {
+    // Map the MIDI value (0-127) to a PWM value (0-255)
+    int pwmValue = map(value, 0, 127, 0, 255);
+
+    // Set the LED brightness using PWM
+    analogWrite(ledPin, pwmValue);
+  }
+}
+
+// One USB-MIDI event packet; the low nibble of the header is the code index
+void handleUsbPacket(const midiEventPacket_t& packet) {
+  byte codeIndex = packet.header & 0x0F;
+  byte bytes[3] = { packet.byte1, packet.byte2, packet.byte3 };
+  int count = 0;
+
+  switch (codeIndex) {
+    case 0x0B:  // control change
+      handleControlChange(packet.byte2, packet.byte3);
+      return;
+    case 0x04:  // SysEx start or continue, 3 bytes
+      count = 3;
+      break;
+    case 0x05:  // SysEx ends with 1 byte
+      count = 1;
+      break;
+    case 0x06:  // SysEx ends with 2 bytes
+      count = 2;
+      break;
+    case 0x07:  // SysEx ends with 3 bytes
+      count = 3;
+      break;
+    default:
+      return;
+  }
+
+  for (int i = 0; i < count; i++) {
+    if (bytes[i] == 0xF0) {  // a new message starts
+      sysexLength = 0;
+      sysexOverflow = false;
+    }
+
+    if (sysexLength < (int) sizeof(sysexBuffer)) {
+      sysexBuffer[sysexLength++] = bytes[i];
+    } else {
+      sysexOverflow = true;
+    }
+  }
+
+  if (codeIndex != 0x04) {
+    if (!sysexOverflow) {
+      handleSysEx(sysexBuffer, sysexLength);
+    }
+    sysexLength = 0;
+  }
+}
+
+// A complete SysEx message, F0 to F7
+void handleSysEx(const byte* data, int length) {
+  if (length < 5 || data[0] != 0xF0 || data[1] != sysexManufacturer || data[2] != sysexProduct) {
+    return;
+  }
+
+  if (data[3] == sysexStateRequest) {
+    sendStateDump();
+  } else if (data[3] == sysexFeedbackDump && length >= 7) {
+    int count = min((int) data[5], (length - 7) / 2);
+    for (int i = 0; i < count; i++) {
+      handleControlChange(data[6 + 2 * i], data[7 + 2 * i]);
+    }
+  }
+}
+
+// Every control's current value in one message
+void sendStateDump() {
+  byte dump[] = { 0xF0, sysexManufacturer, sysexProduct, sysexStateDump,
+                  midiChannel, 1, controllerNumber, (byte) midiValue, 0xF7 };
+  sendSysEx(dump, sizeof(dump));
+
+  Serial.println("Sent state dump");
+}
+
+// Splits a SysEx message into USB-MIDI packets
+void sendSysEx(const byte* data, int length) {
+  int i = 0;
+  while (length - i > 3) {
+    midiEventPacket_t event = {0x04, data[i], data[i + 1], data[i + 2]};
+    MidiUSB.sendMIDI(event);
+    i += 3;
+  }
+
+  int remaining = length - i;
+  midiEventPacket_t last = {(byte) (0x04 + remaining), data[i],
+                            remaining > 1 ? data[i + 1] : (byte) 0,
+                            remaining > 2 ? data[i + 2] : (byte) 0};
+  MidiUSB.sendMIDI(last);
+  MidiUSB.flush();
+}
+
+// Function to send a MIDI Active Sensing (0xFE) message
+void sendActiveSensing() {
+  midiEventPacket_t event = {0x0F, 0xFE, 0, 0};  // single-byte message
+  MidiUSB.sendMIDI(event);
+  MidiUSB.flush();
+}
 /*
 void MyCCFunction(byte channel, byte number, byte value){
     Serial.print("got MIDI msg ");
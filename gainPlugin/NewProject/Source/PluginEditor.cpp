@@ -35,8 +35,9 @@ NewProjectAudioProcessorEditor::NewProjectAudioProcessorEditor (NewProjectAudioP
     addAndMakeVisible(gainSlider);
     //gainSlider.setLookAndFeel(&customLookAndFeel);
 
-    // Start timer to check connection status periodically
-    startTimer(1000); // Check every second
+    // Connection status is a couple of atomic reads, so it can follow
+    // the Active Sensing timeout closely
+    startTimer(100);
 }
 
 NewProjectAudioProcessorEditor::~NewProjectAudioProcessorEditor()
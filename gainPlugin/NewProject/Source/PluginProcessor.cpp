@@ -29,13 +29,13 @@ NewProjectAudioProcessor::NewProjectAudioProcessor()
 {
     midiController = std::make_unique<MidiController>(parameters);
     startMidiInput();  // Start listening to MIDI input
-    startTimer(2000);
+    deviceListConnection = juce::MidiDeviceListConnection::make([this]() { midiDevicesChanged(); });
 }
 
 NewProjectAudioProcessor::~NewProjectAudioProcessor()
 {
+    deviceListConnection.reset();
     stopMidiInput();
-    stopTimer();
 }
 
 //==============================================================================
@@ -106,6 +106,10 @@ void NewProjectAudioProcessor::prepareToPlay (double sampleRate, int samplesPerB
     // Use this method as the place to do any pre-playback
     // initialisation that you need.
     midiController->prepareToPlay();
+    
+    // Resend everything once playback starts
+    lastFeedbackGain = -1;
+    lastFeedbackLed = -1;
 }
 
 void NewProjectAudioProcessor::releaseResources()
@@ -152,10 +156,14 @@ void NewProjectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     
     // Get current gain value from ValueTreeState
     float gainValue = *parameters.getRawParameterValue("gain");
-    if(gainValue>0.5){
-        juce::MidiMessage midiMessage = juce::MidiMessage::controllerEvent(1, 1, 64);
-        midiController->sendMidiMessage(midiMessage);
-    }
+    
+    // The gain changes at block boundaries, so its feedback belongs at the
+    // start of the block. Incoming MIDI stays in the buffer and passes through
+    // to the next plugin with the feedback. The plugin wrappers reserve the
+    // host buffer's storage before playback and only clear() it between
+    // blocks, so two more 3-byte events don't allocate.
+    writeFeedback(midiMessages, gainValue, 0);
+    
     // Apply gain to audio
     for (int channel = 0; channel < totalNumInputChannels; ++channel)
     {
@@ -167,6 +175,30 @@ void NewProjectAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, j
     }
 }
 
+void NewProjectAudioProcessor::writeFeedback(juce::MidiBuffer& output, float gainValue, int samplePosition)
+{
+    const int gain = juce::roundToInt(gainValue * 127.0f);
+    const int led = gainValue > 0.5f ? 64 : 0;
+    
+    if (gain != lastFeedbackGain)
+    {
+        auto message = juce::MidiMessage::controllerEvent(kFeedbackChannel, kGainFeedbackCC, gain);
+        output.addEvent(message, samplePosition);
+        if (feedbackToDevice)
+            midiController->sendMidiMessage(message);
+        lastFeedbackGain = gain;
+    }
+    
+    if (led != lastFeedbackLed)
+    {
+        auto message = juce::MidiMessage::controllerEvent(kFeedbackChannel, kLedFeedbackCC, led);
+        output.addEvent(message, samplePosition);
+        if (feedbackToDevice)
+            midiController->sendMidiMessage(message);
+        lastFeedbackLed = led;
+    }
+}
+
 //==============================================================================
 bool NewProjectAudioProcessor::hasEditor() const
 {
@@ -211,6 +243,9 @@ void NewProjectAudioProcessor::startMidiInput()
         if (midiInputDevice)
             midiInputDevice->start();
     }
+    
+    midiController->setDeviceOpen(midiInputDevice != nullptr,
+                                  midiInputDevice != nullptr ? midiInputDevice->getName() : juce::String());
 }
 
 void NewProjectAudioProcessor::stopMidiInput()
@@ -220,26 +255,32 @@ void NewProjectAudioProcessor::stopMidiInput()
         midiInputDevice->stop();
         midiInputDevice.reset(); // Properly cleanup using unique_ptr
     }
+    
+    midiController->setDeviceOpen(false);
 }
 
 void NewProjectAudioProcessor::handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message)
 {
     if (midiController)
     {
-        midiController->handleIncomingMidiMessage(nullptr, message);
+        midiController->handleIncomingMidiMessage(source, message);
     }
 }
 
-void NewProjectAudioProcessor::timerCallback()
+void NewProjectAudioProcessor::midiDevicesChanged()
 {
+    midiController->devicesChanged();
+    
     auto availableDevices = juce::MidiInput::getAvailableDevices();
-
-    if (!availableDevices.isEmpty() && !midiInputDevice) // If a device is available but not started
-    {
-        startMidiInput();
-    }
-    else if (availableDevices.isEmpty() && midiInputDevice) // If no devices are available but we're still running
+    
+    // Drop the open device if it went away, then take the first one there is
+    if (midiInputDevice
+        && std::none_of(availableDevices.begin(), availableDevices.end(),
+                        [this](const auto& device) { return device.identifier == midiInputDevice->getIdentifier(); }))
     {
         stopMidiInput();
     }
+    
+    if (!availableDevices.isEmpty() && !midiInputDevice)
+        startMidiInput();
 }
@@ -15,8 +15,7 @@
 /**
 */
 class NewProjectAudioProcessor  : public juce::AudioProcessor,
-                                  public juce::MidiInputCallback,
-                                  public juce::Timer
+                                  public juce::MidiInputCallback
 {
 public:
     //==============================================================================
@@ -59,19 +58,23 @@ public:
     juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
     bool isMidiControllerConnected() const
         {
-            midiController->refreshMidiInputs();
             return midiController->isDeviceConnected();
         }
+    // Message thread (editor)
     void sendMidi(const juce::MidiMessage& message)
     {
-        midiController->sendMidiMessage(message);
+        midiController->sendMidiMessageFromMessageThread(message);
     }
+    // Feedback always goes to the plugin's MIDI output; this also sends it
+    // straight to the device through the controller's output queue
+    void setFeedbackToDevice(bool shouldSend) { feedbackToDevice = shouldSend; }
     void startMidiInput();
     void stopMidiInput();
     int getControllerNumber() { return controllerNumber; }
     int getcontrollerValue() { return controllerValue; }
     void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
-    void timerCallback() override;
+    // Message thread: opens or closes the input when devices come and go
+    void midiDevicesChanged();
 
 private:
     //==============================================================================
@@ -81,10 +84,22 @@ private:
     // The MIDI controller
     std::unique_ptr<MidiController> midiController;
     std::unique_ptr<juce::MidiInput> midiInputDevice;
+    // Hotplug notifications instead of polling the device list
+    juce::MidiDeviceListConnection deviceListConnection;
     int controllerNumber;
     int controllerValue;
     // plugin parameters
     juce::AudioProcessorValueTreeState parameters;
     
+    // Controller feedback (gain value, LED state), added to the host's MIDI
+    // buffer for the plugin's MIDI output
+    void writeFeedback(juce::MidiBuffer& output, float gainValue, int samplePosition);
+    int lastFeedbackGain = -1;
+    int lastFeedbackLed = -1;
+    std::atomic<bool> feedbackToDevice { true };
+    static constexpr int kFeedbackChannel = 1;
+    static constexpr int kGainFeedbackCC = 7;
+    static constexpr int kLedFeedbackCC = 1;
+    
     
 };
@@ -10,42 +10,34 @@
 
 // MidiController.cpp
 #include "midiController.h"
+#include "../../../set_gain/Source/ControllerSysEx.h"
 
 //==============================================================================
 MidiController::MidiController(juce::AudioProcessorValueTreeState& apvts)
     : parameters(apvts)
 {
-    // Initialize the device manager with no audio inputs/outputs, but enable MIDI input
-    deviceManager.initialise(0, 2, nullptr, true);
-    
-    // Start checking for controller connections every 2 seconds
-    startTimer(2000);
-    
-    // Initial search for MIDI devices
-    refreshMidiInputs();
-    
 }
 
-MidiController::~MidiController()
+//==============================================================================
+bool MidiController::isDeviceConnected() const
 {
-    stopTimer();
-        
-    // Clean up any MIDI callbacks
-    if (!lastConnectedDeviceID.isEmpty()) {
-        deviceManager.removeMidiInputCallback(lastConnectedDeviceID, this);
-    }
-    // Initialize MIDI output
-    auto availableDevices = juce::MidiOutput::getAvailableDevices();
-    if (!availableDevices.isEmpty())
-    {
-        midiOutputDevice = juce::MidiOutput::openDevice(availableDevices[0].identifier);
-    }
+    return heartbeat.isConnected(sensingTimeoutMs.load(std::memory_order_relaxed));
 }
 
-//==============================================================================
-bool MidiController::isDeviceConnected() const
+void MidiController::setDeviceOpen(bool isOpen, const juce::String& deviceName)
 {
-    return deviceConnected;
+    heartbeat.setOpen(isOpen);
+    outputQueue.setDeviceName(isOpen ? deviceName : juce::String());
+    
+    // Resync both ways in one round trip: ask a gain knob for its positions
+    // and push our feedback state in bulk
+    if (isOpen)
+    {
+        if (ControllerSysEx::isControllerDevice(deviceName))
+            outputQueue.pushSysExFromMessageThread(ControllerSysEx::createStateRequest());
+        
+        outputQueue.resendFeedback();
+    }
 }
 
 void MidiController::processMidiBuffer(const juce::MidiBuffer& midiMessages)
@@ -59,60 +51,42 @@ void MidiController::processMidiBuffer(const juce::MidiBuffer& midiMessages)
 
 void MidiController::prepareToPlay()
 {
-    // Ensure MIDI is initialized properly
-    refreshMidiInputs();
 }
 
 //==============================================================================
 void MidiController::handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message)
 {
+    // Only messages from the device itself show that it's alive
+    if (source != nullptr && heartbeat.messageReceived(message))
+        return;
+    
+    // A state dump stands for the CCs in it
+    if (ControllerSysEx::forEachValue(message, ControllerSysEx::stateDump,
+                                      [this](int, int controller, int value) { handleController(controller, value); }))
+        return;
     
     if (message.isController())  // Check if the message is a MIDI CC message
-    {
-        if (message.getControllerNumber() == kMidiCC)  // Assuming CC#7 (Volume) controls the gain
-        {
-            float midiValue = message.getControllerValue() / 127.0f; // Normalize 0-127 to 0.0-1.0
-            
-            // Update the "gain" parameter in the AudioProcessorValueTreeState
-            parameters.getParameter("gain")->setValueNotifyingHost(midiValue);
-            //deviceConnected = true;
-        }
-        
-    }
+        handleController(message.getControllerNumber(), message.getControllerValue());
 }
 
-void MidiController::sendMidiMessage(const juce::MidiMessage& message)
+void MidiController::handleController(int controllerNumber, int controllerValue)
 {
-    if (midiOutputDevice)
+    if (controllerNumber == kMidiCC)  // Assuming CC#7 (Volume) controls the gain
     {
-        midiOutputDevice->sendMessageNow(message);
+        float midiValue = controllerValue / 127.0f; // Normalize 0-127 to 0.0-1.0
+        
+        // Update the "gain" parameter in the AudioProcessorValueTreeState
+        parameters.getParameter("gain")->setValueNotifyingHost(midiValue);
     }
 }
 
-
-//==============================================================================
-void MidiController::timerCallback()
+void MidiController::sendMidiMessage(const juce::MidiMessage& message)
 {
-    // Periodically check if our device is still connected
-    refreshMidiInputs();
-    // Initialize MIDI output
-    auto availableDevices = juce::MidiOutput::getAvailableDevices();
-    if (!availableDevices.isEmpty())
-    {
-        midiOutputDevice = juce::MidiOutput::openDevice(availableDevices[0].identifier);
-    }
+    outputQueue.push(message);
 }
 
-void MidiController::refreshMidiInputs()
+void MidiController::sendMidiMessageFromMessageThread(const juce::MidiMessage& message)
 {
-    // Get list of all available MIDI input devices
-    auto midiInputs = juce::MidiInput::getAvailableDevices();
-    
-    // If no devices are available at all
-    if (midiInputs.isEmpty())
-    {
-        deviceConnected = false;
-
-    }else{deviceConnected = true;}
-    
+    outputQueue.pushFromMessageThread(message);
 }
+
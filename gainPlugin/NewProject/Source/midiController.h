@@ -11,20 +11,32 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "midiOutputQueue.h"
+#include "../../../set_gain/Source/ActiveSensingMonitor.h"
 
-class MidiController : public juce::MidiInputCallback,
-                       private juce::Timer
+class MidiController : public juce::MidiInputCallback
 {
 public:
     //==============================================================================
     // Constructor now takes a reference to AudioProcessorValueTreeState
     MidiController(juce::AudioProcessorValueTreeState& apvts);
-    ~MidiController() override;
 
     //==============================================================================
-    // Checks if the MIDI controller is connected
+    // Checks if the MIDI controller is connected: its input is open and, if it
+    // sends Active Sensing (0xFE), it has been heard from within the timeout.
+    // Any thread; no device enumeration.
     bool isDeviceConnected() const;
     
+    // Message thread: the processor opened or closed the device input.
+    // Feedback goes to the output with the same name.
+    void setDeviceOpen(bool isOpen, const juce::String& deviceName = {});
+    
+    // Message thread: MIDI devices were added or removed
+    void devicesChanged() { outputQueue.devicesChanged(); }
+    
+    static constexpr int kDefaultActiveSensingTimeoutMs = ActiveSensingMonitor::kDefaultTimeoutMs;
+    void setActiveSensingTimeout(int milliseconds) { sensingTimeoutMs.store((juce::uint32) juce::jmax(1, milliseconds), std::memory_order_relaxed); }
+    
     // Call this from your processor's processBlock
     void processMidiBuffer(const juce::MidiBuffer& midiMessages);
     
@@ -32,33 +44,32 @@ public:
     void prepareToPlay();
     
     //==============================================================================
-    // Send a MIDI message to the controller
+    // Send a MIDI message to the controller. Only queues it, so this is
+    // safe on the audio thread; the sender thread does the device I/O.
     void sendMidiMessage(const juce::MidiMessage& message);
+    // Same, from the message thread
+    void sendMidiMessageFromMessageThread(const juce::MidiMessage& message);
     
-    // MidiInputCallback implementation
+    // MidiInputCallback implementation. Messages with a source come from the
+    // device and keep the connection alive; Active Sensing stops here.
     void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
-    // Refreshes the list of MIDI inputs and finds the controller
-    void refreshMidiInputs();
 private:
     //==============================================================================
-    // Timer callback to check for controller connection
-    void timerCallback() override;
-    
-
-    
-    //==============================================================================
-    juce::AudioDeviceManager deviceManager;
-    juce::String lastConnectedDeviceID;
+    // CC #7 (or the same value from a state dump) drives the gain
+    void handleController(int controllerNumber, int controllerValue);
     
     // Reference to the AudioProcessorValueTreeState that contains the gain parameter
     juce::AudioProcessorValueTreeState& parameters;
     
     // MIDI parameters
     static constexpr int kMidiCC = 7;  // CC #7 is standard for volume control
-    bool deviceConnected = false;
     
-    // MIDI output device
-    std::unique_ptr<juce::MidiOutput> midiOutputDevice;
+    // Whether the open input is still alive, from its traffic
+    ActiveSensingMonitor heartbeat;
+    std::atomic<juce::uint32> sensingTimeoutMs { (juce::uint32) kDefaultActiveSensingTimeoutMs };
+    
+    // MIDI output, opened once and fed from a lock-free queue
+    MidiOutputQueue outputQueue;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiController)
 };
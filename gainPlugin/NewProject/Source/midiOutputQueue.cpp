@@ -0,0 +1,257 @@
+/*
+  ==============================================================================
+
+    midiOutputQueue.cpp
+
+  ==============================================================================
+*/
+
+#include "midiOutputQueue.h"
+#include "../../../set_gain/Source/ControllerSysEx.h"
+#include "../../../set_gain/Source/RealtimeFifo.h"
+
+//==============================================================================
+namespace
+{
+    // How often to look for the output device while it isn't open
+    constexpr juce::uint32 kOpenRetryMs = 2000;
+}
+
+//==============================================================================
+MidiOutputQueue::MidiOutputQueue()
+    : juce::Thread("MIDI feedback sender")
+{
+    latestValue.fill(-1);
+    sentValue.fill(-1);
+    knownValue.fill(-1);
+    startThread();
+}
+
+MidiOutputQueue::~MidiOutputQueue()
+{
+    stopThread(1000);
+}
+
+//==============================================================================
+void MidiOutputQueue::push(const juce::MidiMessage& message)
+{
+    audioQueue.push(message);
+}
+
+void MidiOutputQueue::pushFromMessageThread(const juce::MidiMessage& message)
+{
+    messageQueue.push(message);
+}
+
+void MidiOutputQueue::pushSysExFromMessageThread(const juce::MidiMessage& message)
+{
+    if (! message.isSysEx())
+        return;
+
+    const juce::ScopedLock sl(sysExLock);
+
+    if (pendingSysEx.size() >= kMaxPendingSysEx)
+        pendingSysEx.remove(0);
+
+    pendingSysEx.add(message);
+}
+
+void MidiOutputQueue::setDeviceName(const juce::String& name)
+{
+    {
+        const juce::ScopedLock sl(deviceNameLock);
+        if (name == deviceName)
+            return;
+
+        deviceName = name;
+    }
+
+    requestDeviceCheck();
+}
+
+void MidiOutputQueue::requestDeviceCheck()
+{
+    deviceCheckRequested.store(true, std::memory_order_relaxed);
+    notify();
+}
+
+void MidiOutputQueue::Queue::push(const juce::MidiMessage& message)
+{
+    const int size = message.getRawDataSize();
+    if (size > 3 || message.isSysEx())
+        return;
+
+    juce::uint32 packed = (juce::uint32) size << 24;
+    for (int i = 0; i < size; ++i)
+        packed |= (juce::uint32) message.getRawData()[i] << (8 * i);
+
+    // Full: the sender is behind, drop rather than wait
+    RealtimeFifo::push(fifo, messages, packed);
+}
+
+//==============================================================================
+void MidiOutputQueue::run()
+{
+    while (! threadShouldExit())
+    {
+        if (deviceCheckRequested.exchange(false, std::memory_order_relaxed)
+            || (output == nullptr && juce::Time::getMillisecondCounter() >= nextOpenAttempt))
+            updateDevice();
+
+        drain(audioQueue);
+        drain(messageQueue);
+
+        if (output != nullptr)
+        {
+            sendPendingSysEx();
+
+            if (feedbackDumpRequested.exchange(false, std::memory_order_relaxed))
+                sendFeedbackDump();
+        }
+
+        // Latest value per controller, and only if the device doesn't have it yet
+        for (int i = 0; i < numDirty; ++i)
+        {
+            const int slot = dirtySlots[(size_t) i];
+            const auto value = latestValue[(size_t) slot];
+            latestValue[(size_t) slot] = -1;
+
+            if (value == sentValue[(size_t) slot] || output == nullptr)
+                continue;
+
+            output->sendMessageNow(juce::MidiMessage::controllerEvent(slot / 128 + 1, slot % 128, value));
+            sentValue[(size_t) slot] = value;
+        }
+
+        numDirty = 0;
+        wait(intervalMs.load(std::memory_order_relaxed));
+    }
+}
+
+void MidiOutputQueue::updateDevice()
+{
+    nextOpenAttempt = juce::Time::getMillisecondCounter() + kOpenRetryMs;
+
+    juce::String name;
+    {
+        const juce::ScopedLock sl(deviceNameLock);
+        name = deviceName;
+    }
+
+    const auto availableDevices = juce::MidiOutput::getAvailableDevices();
+
+    // Close the output if it was unplugged or belongs to another controller
+    if (output != nullptr
+        && (output->getName() != name
+            || std::none_of(availableDevices.begin(), availableDevices.end(),
+                            [this](const auto& device) { return device.identifier == output->getIdentifier(); })))
+    {
+        output.reset();
+        deviceOpen.store(false, std::memory_order_relaxed);
+    }
+
+    if (output != nullptr || name.isEmpty())
+        return;
+
+    for (const auto& device : availableDevices)
+    {
+        if (device.name == name)
+        {
+            output = juce::MidiOutput::openDevice(device.identifier);
+            break;
+        }
+    }
+
+    deviceOpen.store(output != nullptr, std::memory_order_relaxed);
+
+    // A new device knows nothing yet; bring it up to date in bulk
+    if (output != nullptr)
+    {
+        sentValue.fill(-1);
+        feedbackDumpRequested.store(true, std::memory_order_relaxed);
+    }
+}
+
+void MidiOutputQueue::drain(Queue& queue)
+{
+    const auto scope = queue.fifo.read(queue.fifo.getNumReady());
+
+    const auto handle = [this, &queue](int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+            send(queue.messages[(size_t) i]);
+    };
+
+    handle(scope.startIndex1, scope.blockSize1);
+    handle(scope.startIndex2, scope.blockSize2);
+}
+
+void MidiOutputQueue::send(juce::uint32 packed)
+{
+    const juce::uint8 status = (juce::uint8) packed;
+
+    // Controllers are coalesced and sent by run()
+    if ((status & 0xf0) == 0xb0)
+    {
+        const int slot = (status & 0x0f) * 128 + (int) ((packed >> 8) & 0x7f);
+
+        if (latestValue[(size_t) slot] < 0)
+            dirtySlots[(size_t) numDirty++] = (juce::int16) slot;
+
+        latestValue[(size_t) slot] = (juce::int16) ((packed >> 16) & 0x7f);
+        knownValue[(size_t) slot] = latestValue[(size_t) slot];
+        return;
+    }
+
+    // Anything else goes out in order, as it came
+    if (output != nullptr)
+    {
+        const juce::uint8 data[3] = { status, (juce::uint8) (packed >> 8), (juce::uint8) (packed >> 16) };
+        output->sendMessageNow(juce::MidiMessage(data, (int) (packed >> 24)));
+    }
+}
+
+void MidiOutputQueue::sendPendingSysEx()
+{
+    // Taken out under the lock, sent without it
+    juce::Array<juce::MidiMessage> messages;
+    {
+        const juce::ScopedLock sl(sysExLock);
+        messages.swapWith(pendingSysEx);
+    }
+
+    for (const auto& message : messages)
+        output->sendMessageNow(message);
+}
+
+void MidiOutputQueue::sendFeedbackDump()
+{
+    // Other devices aren't sent our private SysEx; they get the values as CCs
+    const bool isGainKnob = ControllerSysEx::isControllerDevice(output->getName());
+    
+    // One dump per channel that has anything, usually just the one
+    for (int channel = 0; channel < 16; ++channel)
+    {
+        std::array<juce::uint8, ControllerSysEx::kMaxValues> controllers {}, values {};
+        int numValues = 0;
+
+        for (int controller = 0; controller < 128 && numValues < ControllerSysEx::kMaxValues; ++controller)
+        {
+            const int slot = channel * 128 + controller;
+            if (knownValue[(size_t) slot] < 0)
+                continue;
+
+            controllers[(size_t) numValues] = (juce::uint8) controller;
+            values[(size_t) numValues] = (juce::uint8) knownValue[(size_t) slot];
+            sentValue[(size_t) slot] = knownValue[(size_t) slot];
+            ++numValues;
+        }
+
+        if (numValues > 0 && isGainKnob)
+            output->sendMessageNow(ControllerSysEx::createDump(ControllerSysEx::feedbackDump, channel + 1,
+                                                               controllers.data(), values.data(), numValues));
+        
+        for (int i = 0; i < numValues && ! isGainKnob; ++i)
+            output->sendMessageNow(juce::MidiMessage::controllerEvent(channel + 1, controllers[(size_t) i], values[(size_t) i]));
+    }
+}
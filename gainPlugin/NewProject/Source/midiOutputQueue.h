@@ -0,0 +1,104 @@
+/*
+  ==============================================================================
+
+    midiOutputQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Sends controller feedback to the MIDI output device from its own thread,
+// so the audio thread never does device I/O.
+//
+// Messages go into wait-free FIFOs (one per producing thread). The sender
+// wakes at most maxRate times a second, keeps only the latest value of each
+// controller and skips values the device already has. The output is the
+// device with the controller's name; it is kept open until that device goes
+// away or the controller changes.
+//
+// When a device opens, or on request, the known value of every controller
+// goes out again: to a gain knob as one feedback dump SysEx (see
+// ControllerSysEx.h) instead of a CC each, to anything else as CCs.
+class MidiOutputQueue : private juce::Thread
+{
+public:
+    //==============================================================================
+    static constexpr int kCapacity = 256;
+    static constexpr int kDefaultMaxRateHz = 100;
+
+    MidiOutputQueue();
+    ~MidiOutputQueue() override;
+
+    //==============================================================================
+    // Audio thread, wait-free. Short messages only; the rest is ignored.
+    void push(const juce::MidiMessage& message);
+
+    // Same, for the message thread (e.g. buttons in the editor)
+    void pushFromMessageThread(const juce::MidiMessage& message);
+
+    // Message thread: SysEx goes out in order on the next wake-up with a
+    // device open. Only the last few are kept while there is none.
+    void pushSysExFromMessageThread(const juce::MidiMessage& message);
+
+    // Any thread: send the whole feedback state again as a bulk dump
+    void resendFeedback() { feedbackDumpRequested.store(true, std::memory_order_relaxed); }
+
+    // Message thread: send to the output with this name, usually the one of
+    // the controller's input. Empty closes the output.
+    void setDeviceName(const juce::String& name);
+
+    // Message thread: MIDI devices were added or removed
+    void devicesChanged() { requestDeviceCheck(); }
+
+    // Most updates per second for any one controller
+    void setMaxRate(int rateHz) { intervalMs.store(juce::jmax(1, 1000 / juce::jmax(1, rateHz)), std::memory_order_relaxed); }
+
+    bool isDeviceOpen() const { return deviceOpen.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    struct Queue
+    {
+        juce::AbstractFifo fifo { kCapacity };
+        std::array<juce::uint32, kCapacity> messages {};
+
+        void push(const juce::MidiMessage& message);
+    };
+
+    void run() override;
+    void requestDeviceCheck();
+    void updateDevice();
+    void drain(Queue& queue);
+    void send(juce::uint32 packed);
+    void sendPendingSysEx();
+    void sendFeedbackDump();
+
+    Queue audioQueue, messageQueue;
+    std::atomic<int> intervalMs { 1000 / kDefaultMaxRateHz };
+    std::atomic<bool> deviceOpen { false };
+    std::atomic<bool> feedbackDumpRequested { false };
+    std::atomic<bool> deviceCheckRequested { false };
+
+    juce::CriticalSection deviceNameLock;
+    juce::String deviceName;
+
+    static constexpr int kMaxPendingSysEx = 8;
+    juce::CriticalSection sysExLock;
+    juce::Array<juce::MidiMessage> pendingSysEx;
+
+    // Sender thread only
+    std::unique_ptr<juce::MidiOutput> output;
+    juce::uint32 nextOpenAttempt = 0;
+
+    static constexpr int kNumControllerSlots = 16 * 128;
+    std::array<juce::int16, kNumControllerSlots> latestValue;   // -1 = nothing new
+    std::array<juce::int16, kNumControllerSlots> sentValue;     // -1 = never sent
+    std::array<juce::int16, kNumControllerSlots> knownValue;    // -1 = never pushed
+    std::array<juce::int16, kNumControllerSlots> dirtySlots {};
+    int numDirty = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiOutputQueue)
+};
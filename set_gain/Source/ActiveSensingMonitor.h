@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    ActiveSensingMonitor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Tells from an open MIDI input's traffic whether the device is still there.
+// A device that sends Active Sensing (0xFE) is taken as gone once it stays
+// silent for longer than the timeout; one that never sends it counts as
+// connected for as long as its input is open. Nothing is enumerated, so the
+// check is cheap enough for a UI timer or the audio thread.
+//
+// Shared with the gainPlugin project, which watches its single input the
+// same way MidiDeviceService watches each of its slots.
+class ActiveSensingMonitor
+{
+public:
+    //==============================================================================
+    static constexpr int kDefaultTimeoutMs = 300;
+
+    // Message thread: the input was opened or closed. A newly opened device
+    // hasn't shown yet whether it sends Active Sensing.
+    void setOpen(bool isOpen)
+    {
+        sensing.store(false, std::memory_order_relaxed);
+        lastMessageMs.store(juce::Time::getMillisecondCounter(), std::memory_order_relaxed);
+        open.store(isOpen, std::memory_order_relaxed);
+    }
+
+    // MIDI thread, for every message from the device. Returns true for Active
+    // Sensing, which has done its job here and needn't be passed on.
+    bool messageReceived(const juce::MidiMessage& message)
+    {
+        lastMessageMs.store(juce::Time::getMillisecondCounter(), std::memory_order_relaxed);
+
+        if (! message.isActiveSense())
+            return false;
+
+        sensing.store(true, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Any thread
+    bool isOpen() const { return open.load(std::memory_order_relaxed); }
+
+    bool isConnected(juce::uint32 timeoutMs) const
+    {
+        if (! isOpen())
+            return false;
+
+        // getMillisecondCounter() wraps every 49 days; the unsigned difference
+        // is still the elapsed time across the wrap
+        return ! sensing.load(std::memory_order_relaxed)
+            || juce::Time::getMillisecondCounter() - lastMessageMs.load(std::memory_order_relaxed) <= timeoutMs;
+    }
+
+private:
+    //==============================================================================
+    std::atomic<bool> open { false };
+    std::atomic<bool> sensing { false };
+    std::atomic<juce::uint32> lastMessageMs { 0 };
+};
@@ -0,0 +1,329 @@
+/*
+  ==============================================================================
+
+    AutomationHistory.cpp
+
+  ==============================================================================
+*/
+
+#include "AutomationHistory.h"
+#include "RealtimeFifo.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int kDrainIntervalMs = 100;
+
+    // Three varints of up to 10 bytes
+    constexpr int kMaxPointBytes = 30;
+
+    int writeVarint(juce::uint8* out, juce::uint64 value)
+    {
+        int size = 0;
+        while (value >= 0x80)
+        {
+            out[size++] = (juce::uint8) ((value & 0x7f) | 0x80);
+            value >>= 7;
+        }
+        out[size++] = (juce::uint8) value;
+        return size;
+    }
+
+    juce::uint64 readVarint(const juce::uint8* data, int size, int& offset)
+    {
+        juce::uint64 value = 0;
+        for (int shift = 0; shift < 64 && offset < size; shift += 7)
+        {
+            const auto byte = data[offset++];
+            value |= (juce::uint64) (byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                break;
+        }
+        return value;
+    }
+
+    juce::uint64 zigzag(int value)     { return (juce::uint64) (((juce::uint32) value << 1) ^ (juce::uint32) (value >> 31)); }
+    int unzigzag(juce::uint64 value)   { return (int) (value >> 1) ^ -(int) (value & 1); }
+
+    juce::uint64 zigzag64(juce::int64 value)   { return ((juce::uint64) value << 1) ^ (juce::uint64) (value >> 63); }
+    juce::int64 unzigzag64(juce::uint64 value) { return (juce::int64) (value >> 1) ^ -(juce::int64) (value & 1); }
+
+    const char* getSourceName(AutomationHistory::Source source)
+    {
+        switch (source)
+        {
+            case AutomationHistory::Source::midi: return "midi";
+            case AutomationHistory::Source::ui:   return "ui";
+            case AutomationHistory::Source::host:
+            default:                              return "host";
+        }
+    }
+}
+
+//==============================================================================
+AutomationHistory::AutomationHistory()
+{
+    startTimer(kDrainIntervalMs);
+}
+
+AutomationHistory::~AutomationHistory()
+{
+    stopTimer();
+}
+
+void AutomationHistory::prepareToPlay(double newSampleRate)
+{
+    if (newSampleRate == sampleRate.load(std::memory_order_relaxed))
+        return;
+
+    // Sample positions from before can't be mixed with the new rate
+    sampleRate.store(newSampleRate, std::memory_order_relaxed);
+    generation.store(generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void AutomationHistory::clear()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    generation.store(generation.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    drain();
+}
+
+//==============================================================================
+void AutomationHistory::setPlayhead(juce::int64 blockStart, const juce::Optional<juce::AudioPlayHead::PositionInfo>& position)
+{
+    const auto timeInSamples = position.hasValue() ? position->getTimeInSamples() : juce::Optional<juce::int64>();
+    playing = timeInSamples.hasValue() && position->getIsPlaying();
+    playheadOffset = playing ? *timeInSamples - blockStart : 0;
+}
+
+void AutomationHistory::record(juce::int64 samplePosition, float value, Source source)
+{
+    const auto currentGeneration = generation.load(std::memory_order_acquire);
+    if (currentGeneration != recordedGeneration)
+    {
+        recordedGeneration = currentGeneration;
+        hasRecorded = false;
+    }
+
+    const RawPoint point { samplePosition, (juce::uint16) juce::roundToInt(juce::jlimit(0.0f, 1.0f, value) * 65535.0f),
+                           source, currentGeneration, playing, playheadOffset };
+
+    if (hasRecorded && point.value == lastRecorded.value)
+    {
+        lastSeen = point;   // the hold goes on
+        return;
+    }
+
+    // End of a hold: keep its last point, so the change stays a step
+    // instead of a ramp across the whole hold
+    if (hasRecorded && lastSeen.samplePosition != lastRecorded.samplePosition)
+        push(lastSeen);
+
+    push(point);
+    lastRecorded = lastSeen = point;
+    hasRecorded = true;
+}
+
+void AutomationHistory::push(const RawPoint& point)
+{
+    if (! RealtimeFifo::push(fifo, pending, point))
+        numDropped.store(numDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void AutomationHistory::timerCallback()
+{
+    drain();
+}
+
+void AutomationHistory::drain()
+{
+    const auto currentGeneration = generation.load(std::memory_order_acquire);
+
+    if (currentGeneration != encodedGeneration)
+    {
+        chunks.clear();
+        origin = -1;
+        encodedGeneration = currentGeneration;
+    }
+
+    const auto scope = fifo.read(fifo.getNumReady());
+
+    const auto handle = [this](int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+            if (pending[(size_t) i].generation == encodedGeneration)
+                encode(pending[(size_t) i]);
+    };
+
+    handle(scope.startIndex1, scope.blockSize1);
+    handle(scope.startIndex2, scope.blockSize2);
+}
+
+void AutomationHistory::encode(const RawPoint& point)
+{
+    if (origin < 0)
+        origin = point.samplePosition;
+
+    // Every chunk starts from the origin and a value of 0, so it decodes on its own
+    if (chunks.empty() || chunks.back()->size + kMaxPointBytes > kChunkBytes)
+    {
+        if ((int) chunks.size() >= kMaxChunks)
+            chunks.pop_front();
+
+        chunks.push_back(std::make_unique<Chunk>());
+        lastEncoded = { origin, 0, point.source, encodedGeneration, false, 0 };
+    }
+
+    auto& chunk = *chunks.back();
+    const auto delta = (juce::uint64) juce::jmax((juce::int64) 0, point.samplePosition - lastEncoded.samplePosition);
+
+    chunk.size += writeVarint(chunk.bytes.data() + chunk.size,
+                              delta << 3 | (juce::uint64) (point.hasPlayhead ? 4 : 0) | (juce::uint64) point.source);
+    chunk.size += writeVarint(chunk.bytes.data() + chunk.size, zigzag((int) point.value - (int) lastEncoded.value));
+
+    // Relative to the last point that had one, so a steady transport costs a byte
+    if (point.hasPlayhead)
+        chunk.size += writeVarint(chunk.bytes.data() + chunk.size, zigzag64(point.playheadOffset - lastEncoded.playheadOffset));
+
+    const auto lastOffset = point.hasPlayhead ? point.playheadOffset : lastEncoded.playheadOffset;
+    lastEncoded = point;
+    lastEncoded.playheadOffset = lastOffset;
+}
+
+std::vector<AutomationHistory::Point> AutomationHistory::getPoints()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    drain();
+
+    std::vector<Point> points;
+    const double rate = sampleRate.load(std::memory_order_relaxed);
+
+    for (const auto& chunk : chunks)
+    {
+        juce::int64 samples = 0, playheadOffset = 0;
+        int value = 0;
+
+        for (int offset = 0; offset < chunk->size;)
+        {
+            const auto header = readVarint(chunk->bytes.data(), chunk->size, offset);
+            value += unzigzag(readVarint(chunk->bytes.data(), chunk->size, offset));
+            samples += (juce::int64) (header >> 3);
+
+            Point point { (double) samples / rate, {}, (float) value / 65535.0f, (Source) (header & 3) };
+
+            if ((header & 4) != 0)
+            {
+                playheadOffset += unzigzag64(readVarint(chunk->bytes.data(), chunk->size, offset));
+                point.playheadSeconds = (double) (origin + samples + playheadOffset) / rate;
+            }
+
+            points.push_back(point);
+        }
+    }
+
+    return points;
+}
+
+//==============================================================================
+std::vector<AutomationHistory::Point> AutomationHistory::simplify(const std::vector<Point>& points, float tolerance)
+{
+    if (points.size() < 3)
+        return points;
+
+    std::vector<bool> keep(points.size(), false);
+    std::vector<std::pair<size_t, size_t>> stack;
+
+    // Each run of one source is simplified on its own, ends included
+    for (size_t start = 0; start < points.size();)
+    {
+        size_t end = start;
+        while (end + 1 < points.size() && points[end + 1].source == points[start].source)
+            ++end;
+
+        keep[start] = keep[end] = true;
+        stack.push_back({ start, end });
+
+        while (! stack.empty())
+        {
+            const auto [first, last] = stack.back();
+            stack.pop_back();
+
+            const auto& a = points[first];
+            const auto& b = points[last];
+            const double span = b.timeSeconds - a.timeSeconds;
+            float worstError = 0.0f;
+            size_t worst = first;
+
+            // Value error against the straight line between the ends, which is
+            // what the host draws between two breakpoints
+            for (size_t i = first + 1; i < last; ++i)
+            {
+                const double t = span > 0.0 ? (points[i].timeSeconds - a.timeSeconds) / span : 0.0;
+                const float error = std::abs(points[i].value - (a.value + (float) t * (b.value - a.value)));
+
+                if (error > worstError)
+                {
+                    worstError = error;
+                    worst = i;
+                }
+            }
+
+            if (worstError > tolerance)
+            {
+                keep[worst] = true;
+                stack.push_back({ first, worst });
+                stack.push_back({ worst, last });
+            }
+        }
+
+        start = end + 1;
+    }
+
+    std::vector<Point> simplified;
+    for (size_t i = 0; i < points.size(); ++i)
+        if (keep[i])
+            simplified.push_back(points[i]);
+
+    return simplified;
+}
+
+juce::MidiFile AutomationHistory::toMidiFile(const std::vector<Point>& points, int channel, int controller)
+{
+    juce::MidiMessageSequence sequence;
+    int lastValue = -1;
+
+    for (const auto& point : points)
+    {
+        const int value = juce::roundToInt(point.value * 16383.0f);
+        if (value == lastValue)
+            continue;
+
+        const double ticks = point.timeSeconds * 1000.0;
+        sequence.addEvent(juce::MidiMessage::controllerEvent(channel, controller, value >> 7), ticks);
+        sequence.addEvent(juce::MidiMessage::controllerEvent(channel, controller + 32, value & 0x7f), ticks);
+        lastValue = value;
+    }
+
+    // 25 frames x 40 subframes: one tick per millisecond
+    juce::MidiFile file;
+    file.setSmpteTimeFormat(25, 40);
+    file.addTrack(sequence);
+    return file;
+}
+
+juce::String AutomationHistory::toBreakpointCsv(const std::vector<Point>& points)
+{
+    juce::String csv;
+    csv << "time_s,playhead_s,value,source\n";
+
+    for (const auto& point : points)
+        csv << juce::String(point.timeSeconds, 6) << ","
+            << (point.playheadSeconds.hasValue() ? juce::String(*point.playheadSeconds, 6) : juce::String()) << ","
+            << juce::String(point.value, 5) << "," << getSourceName(point.source) << "\n";
+
+    return csv;
+}
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    AutomationHistory.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Records the gain the processor actually applied, and what moved it, so a
+// hardware performance can be turned into light automation afterwards.
+//
+// The audio thread reports the gain once or twice a block; only changes are
+// kept, plus the last point of a hold, so a steady value costs nothing and a
+// step stays a step. Each point also carries where the host's playhead was,
+// so it can be placed on the session timeline. Points go through a wait-free
+// FIFO to the message thread, which delta-encodes them into fixed-size chunks:
+//
+//   varint  samples since the previous point << 3 | has playhead << 2 | source
+//   varint  zigzag change of the 16-bit value
+//   varint  zigzag change of playhead - sample position, if it has a playhead
+//
+// usually 2-4 bytes a point, plus one while the transport plays: the playhead
+// only moves against the sample count when it jumps. Each chunk starts from
+// absolute values, so when the history is full the oldest chunk is simply
+// dropped.
+class AutomationHistory : private juce::Timer
+{
+public:
+    //==============================================================================
+    enum class Source : juce::uint8 { midi = 0, host = 1, ui = 2 };
+
+    struct Point
+    {
+        double timeSeconds = 0.0;   // since the history was cleared
+        juce::Optional<double> playheadSeconds; // host timeline, if the transport was playing
+        float value = 0.0f;         // normalised 0-1
+        Source source = Source::host;
+    };
+
+    static constexpr int kChunkBytes = 4096;
+    static constexpr int kMaxChunks = 64;
+    static constexpr int kCapacity = 1024;
+
+    AutomationHistory();
+    ~AutomationHistory() override;
+
+    // Not concurrent with record(). A new sample rate starts a new history.
+    void prepareToPlay(double sampleRate);
+
+    // Audio thread, once a block before record(): the host's position at
+    // blockStart, which counts samples like record() does
+    void setPlayhead(juce::int64 blockStart, const juce::Optional<juce::AudioPlayHead::PositionInfo>& position);
+
+    // Audio thread, wait-free. samplePosition counts from the first block.
+    void record(juce::int64 samplePosition, float value, Source source);
+
+    // Points lost because the message thread fell behind
+    int getNumDropped() const { return numDropped.load(std::memory_order_relaxed); }
+
+    // Message thread
+    std::vector<Point> getPoints();
+    void clear();
+    size_t getSizeInBytes() const { return (size_t) chunks.size() * kChunkBytes; }
+
+    //==============================================================================
+    // Fewer points with the same shape (Ramer-Douglas-Peucker on the value
+    // error). Where the source changes is always kept.
+    static std::vector<Point> simplify(const std::vector<Point>& points, float tolerance);
+
+    // 14-bit CC (MSB then LSB) at millisecond resolution, ready to play back
+    // into the default mapping
+    static juce::MidiFile toMidiFile(const std::vector<Point>& points, int channel = 1, int controller = 7);
+
+    // time_s,playhead_s,value,source per line; playhead_s is empty where the
+    // transport wasn't playing
+    static juce::String toBreakpointCsv(const std::vector<Point>& points);
+
+private:
+    //==============================================================================
+    struct RawPoint
+    {
+        juce::int64 samplePosition = 0;
+        juce::uint16 value = 0;
+        Source source = Source::host;
+        juce::uint32 generation = 0;
+        bool hasPlayhead = false;
+        juce::int64 playheadOffset = 0;     // playhead - samplePosition, in samples
+    };
+
+    struct Chunk
+    {
+        std::array<juce::uint8, kChunkBytes> bytes;
+        int size = 0;
+    };
+
+    void timerCallback() override;
+    void drain();
+    void push(const RawPoint& point);
+    void encode(const RawPoint& point);
+
+    juce::AbstractFifo fifo { kCapacity };
+    std::array<RawPoint, kCapacity> pending;
+    std::atomic<int> numDropped { 0 };
+    std::atomic<double> sampleRate { 44100.0 };
+
+    // Bumped to start a new history; points from an older one are discarded
+    std::atomic<juce::uint32> generation { 0 };
+
+    // Audio thread only
+    RawPoint lastRecorded, lastSeen;
+    bool playing = false;
+    juce::int64 playheadOffset = 0;
+    bool hasRecorded = false;
+    juce::uint32 recordedGeneration = 0;
+
+    // Message thread only
+    std::deque<std::unique_ptr<Chunk>> chunks;
+    RawPoint lastEncoded;
+    juce::int64 origin = -1;
+    juce::uint32 encodedGeneration = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AutomationHistory)
+};
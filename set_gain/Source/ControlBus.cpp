@@ -0,0 +1,83 @@
+/*
+  ==============================================================================
+
+    ControlBus.cpp
+
+  ==============================================================================
+*/
+
+#include "ControlBus.h"
+#include "ControllerSysEx.h"
+
+//==============================================================================
+namespace
+{
+    // Group n is driven by this controller on channel n
+    constexpr int kGroupController = 7;
+}
+
+//==============================================================================
+ControlBus::ControlBus()
+{
+    for (auto& slot : slots)
+        slot.store(0, std::memory_order_relaxed);
+
+    deviceService->addCallback(this);
+}
+
+ControlBus::~ControlBus()
+{
+    deviceService->removeCallback(this);
+}
+
+//==============================================================================
+bool ControlBus::read(int group, juce::uint32& sequence, float& value) const
+{
+    if (! juce::isPositiveAndBelow(group - 1, kNumGroups))
+        return false;
+
+    const auto packed = slots[(size_t) group - 1].load(std::memory_order_acquire);
+    sequence = (juce::uint32) (packed >> 32);
+
+    if (sequence == 0)
+        return false;
+
+    const auto bits = (juce::uint32) packed;
+    std::memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+//==============================================================================
+void ControlBus::handleDeviceMidi(int deviceSlot, const juce::MidiMessage& message)
+{
+    if (! juce::isPositiveAndBelow(deviceSlot, MidiDeviceService::kMaxDevices))
+        return;
+
+    auto& parser = parsers[(size_t) deviceSlot];
+
+    const auto handleController = [this, &parser](int channel, int controller, int value)
+    {
+        HighResControllerParser::Event event;
+
+        if (parser.process(channel, controller, value, event) && event.type == HighResControllerParser::Type::controller
+            && event.number == kGroupController)
+            publish(event.channel, event.getNormalised());
+    };
+
+    // A state dump stands for the CCs in it, as in the processor
+    if (message.isController())
+        handleController(message.getChannel(), message.getControllerNumber(), message.getControllerValue());
+    else
+        ControllerSysEx::forEachValue(message, ControllerSysEx::stateDump, handleController);
+}
+
+void ControlBus::publish(int group, float value)
+{
+    // Never 0, which means "nothing published yet"
+    auto& sequence = sequences[(size_t) group - 1];
+    sequence = sequence == 0xffffffffu ? 1 : sequence + 1;
+
+    juce::uint32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    slots[(size_t) group - 1].store(((juce::uint64) sequence << 32) | bits, std::memory_order_release);
+}
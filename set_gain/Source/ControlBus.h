@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    ControlBus.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HighResControllerParser.h"
+#include "MidiDeviceService.h"
+
+// One per process, like MidiDeviceService: lets one hardware control drive
+// every plugin instance in a group, VCA-style.
+//
+// The bus subscribes to the device service once and decodes each controller
+// once, on the MIDI thread. The mapping is fixed: group n follows CC 7 on
+// channel n, 14-bit when CC 39 follows it as the LSB, from any device. The
+// value goes into the group's slot (value plus sequence number, one 64-bit
+// atomic). Instances in the group read the slot at the start of each block
+// and apply their own offset and scale, so nothing is called per instance.
+class ControlBus : private MidiDeviceService::Callback
+{
+public:
+    //==============================================================================
+    static constexpr int kNumGroups = 16;
+
+    ControlBus();
+    ~ControlBus() override;
+
+    // Any thread. Returns false if nothing was ever published to the group;
+    // otherwise the value 0-1 and a sequence number that changes with it.
+    bool read(int group, juce::uint32& sequence, float& value) const;
+
+private:
+    //==============================================================================
+    void handleDeviceMidi(int deviceSlot, const juce::MidiMessage& message) override;
+    void publish(int group, float value);
+
+    juce::SharedResourcePointer<MidiDeviceService> deviceService;
+
+    // Sequence in the top 32 bits, float bits in the bottom 32
+    std::array<std::atomic<juce::uint64>, kNumGroups> slots;
+
+    // MIDI thread only: the service serialises its callbacks
+    std::array<HighResControllerParser, MidiDeviceService::kMaxDevices> parsers;
+    std::array<juce::uint32, kNumGroups> sequences {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ControlBus)
+};
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    ControlEventCoalescer.cpp
+
+  ==============================================================================
+*/
+
+#include "ControlEventCoalescer.h"
+
+//==============================================================================
+void ControlEventCoalescer::clear()
+{
+    // Only the slots used last block need resetting
+    for (int i = 0; i < numChanges; ++i)
+        changes[(size_t) order[(size_t) i]].parameterIndex = -1;
+
+    numChanges = 0;
+    numEvents = 0;
+}
+
+void ControlEventCoalescer::add(int parameterIndex, float normalisedValue, int samplePosition)
+{
+    if (! juce::isPositiveAndBelow(parameterIndex, ParameterBridge::kMaxParameters))
+        return;
+
+    ++numEvents;
+    auto& change = changes[(size_t) parameterIndex];
+
+    if (change.parameterIndex < 0)
+    {
+        change.parameterIndex = parameterIndex;
+        change.samplePosition = samplePosition;
+        order[(size_t) numChanges++] = parameterIndex;
+    }
+
+    change.normalisedValue = normalisedValue;
+}
+
+const ControlEventCoalescer::Change* ControlEventCoalescer::findChange(int parameterIndex) const
+{
+    if (! juce::isPositiveAndBelow(parameterIndex, ParameterBridge::kMaxParameters))
+        return nullptr;
+
+    const auto& change = changes[(size_t) parameterIndex];
+    return change.parameterIndex >= 0 ? &change : nullptr;
+}
@@ -0,0 +1,58 @@
+/*
+  ==============================================================================
+
+    ControlEventCoalescer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterBridge.h"
+
+// Collapses a block's worth of MIDI-driven parameter changes into at most
+// one change per parameter: the last value, starting at the position of the
+// first event. That's all the smoother needs, so a controller sending CCs
+// at hundreds of Hz costs one parameter update per block instead of one per
+// message.
+//
+// Works on parameter changes rather than raw CCs, so 14-bit pairs and NRPN
+// sequences are parsed in full before anything is dropped. Audio thread only.
+class ControlEventCoalescer
+{
+public:
+    //==============================================================================
+    struct Change
+    {
+        int parameterIndex = -1;
+        int samplePosition = 0;     // of the first event for the parameter
+        float normalisedValue = 0.0f;
+    };
+
+    ControlEventCoalescer() = default;
+
+    // Call at the start of each block
+    void clear();
+
+    void add(int parameterIndex, float normalisedValue, int samplePosition);
+
+    // Changes in order of their first event
+    int getNumChanges() const { return numChanges; }
+    const Change& getChange(int index) const { return changes[(size_t) order[(size_t) index]]; }
+
+    // nullptr if the parameter didn't change this block
+    const Change* findChange(int parameterIndex) const;
+
+    // Events received vs. changes kept, since the last clear()
+    int getNumEvents() const { return numEvents; }
+
+private:
+    //==============================================================================
+    std::array<Change, ParameterBridge::kMaxParameters> changes;
+    std::array<int, ParameterBridge::kMaxParameters> order {};
+    int numChanges = 0;
+    int numEvents = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ControlEventCoalescer)
+};
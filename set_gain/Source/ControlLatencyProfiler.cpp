@@ -0,0 +1,86 @@
+/*
+  ==============================================================================
+
+    ControlLatencyProfiler.cpp
+
+  ==============================================================================
+*/
+
+#include "ControlLatencyProfiler.h"
+
+//==============================================================================
+ControlLatencyProfiler::ControlLatencyProfiler() = default;
+
+void ControlLatencyProfiler::prepareToPlay(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    numPending = 0;
+    reset();
+}
+
+//==============================================================================
+void ControlLatencyProfiler::beginBlock(double blockStartSeconds)
+{
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+    {
+        for (auto& bins : dispatchBins)
+            bins.clear();
+
+        for (auto& bins : effectBins)
+            bins.clear();
+    }
+
+    blockStart = blockStartSeconds;
+
+    // A gain event that never changed the gain (same value, bypassed) isn't
+    // carried into the next block
+    numPending = 0;
+}
+
+void ControlLatencyProfiler::addGainEvent(Path path, double arrivalSeconds)
+{
+    // One clock read per event, only for events that drive the gain
+    const double now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    dispatchBins[(size_t) path].add((now - arrivalSeconds) * 1000.0, kBinMilliseconds);
+
+    if (numPending < kMaxPendingEvents)
+        pending[(size_t) numPending++] = { path, arrivalSeconds };
+}
+
+void ControlLatencyProfiler::gainApplied(int samplePosition)
+{
+    const double effectTime = blockStart + samplePosition / sampleRate;
+
+    for (int i = 0; i < numPending; ++i)
+        effectBins[(size_t) pending[(size_t) i].first].add((effectTime - pending[(size_t) i].second) * 1000.0, kBinMilliseconds);
+
+    numPending = 0;
+}
+
+ControlLatencyProfiler::Snapshot ControlLatencyProfiler::getSnapshot() const
+{
+    Snapshot s;
+
+    for (size_t path = 0; path < (size_t) kNumPaths; ++path)
+    {
+        s.dispatch[path] = read(dispatchBins[path]);
+        s.effect[path] = read(effectBins[path]);
+    }
+
+    return s;
+}
+
+ControlLatencyProfiler::Histogram ControlLatencyProfiler::read(const RealtimeHistogram<kNumBins>& bins)
+{
+    Histogram h;
+    h.counts = bins.getCounts();
+    h.numEvents = bins.getNumValues();
+    h.maxMilliseconds = bins.getMaxValue();
+    return h;
+}
+
+//==============================================================================
+double ControlLatencyProfiler::Histogram::getPercentile(double fraction) const
+{
+    return RealtimeHistogram<kNumBins>::getPercentile(counts, fraction, kBinMilliseconds);
+}
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    ControlLatencyProfiler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RealtimeHistogram.h"
+
+// Measures how long a gain controller takes to reach the audio, separately
+// for device MIDI and host MIDI. Each event gets two latencies:
+//  - dispatch: arrival until processBlock mapped it
+//  - effect:   arrival until the sample where the gain changed, taking the
+//              block as starting when processBlock was called
+//
+// Device MIDI is stamped in the MIDI callback, so its numbers include the
+// wait for the next block. Host MIDI carries no arrival time, so its
+// "arrival" is the start of the block it came in: the host path measures
+// only the time inside processBlock, not how long the host held the event.
+//
+// Times use the Time::getMillisecondCounterHiRes() clock. The audio thread is
+// the only writer; the editor reads snapshots, so everything shared is a
+// relaxed atomic, as in ProcessLoadProfiler.
+class ControlLatencyProfiler
+{
+public:
+    //==============================================================================
+    enum class Path { device = 0, hostBlock = 1 };   // see above for what hostBlock measures
+    static constexpr int kNumPaths = 2;
+
+    // 0.25 ms bins; the last one collects everything at or above kMaxMilliseconds
+    static constexpr double kBinMilliseconds = 0.25;
+    static constexpr int kNumBins = 201;
+    static constexpr double kMaxMilliseconds = (kNumBins - 1) * kBinMilliseconds;
+
+    struct Histogram
+    {
+        RealtimeHistogram<kNumBins>::Counts counts {};
+        juce::uint64 numEvents = 0;
+        double maxMilliseconds = 0.0;
+
+        // Latency in ms below which the given fraction (0-1) of events fall
+        double getPercentile(double fraction) const;
+    };
+
+    struct Snapshot
+    {
+        std::array<Histogram, kNumPaths> dispatch, effect;
+    };
+
+    //==============================================================================
+    ControlLatencyProfiler();
+
+    // Call this in the plugin's prepareToPlay method
+    void prepareToPlay(double sampleRate);
+
+    // Audio thread only. Call beginBlock first, then addGainEvent for each
+    // event mapped to the gain, then gainApplied once the change is in the
+    // buffer. Times are in seconds.
+    void beginBlock(double blockStartSeconds);
+    // Host events pass the block start as their arrival
+    void addGainEvent(Path path, double arrivalSeconds);
+    void gainApplied(int samplePosition);
+
+    double getBlockStartSeconds() const { return blockStart; }
+
+    // Message thread: read the current state, or ask the audio thread to clear it
+    Snapshot getSnapshot() const;
+    void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    static Histogram read(const RealtimeHistogram<kNumBins>& bins);
+
+    std::array<RealtimeHistogram<kNumBins>, kNumPaths> dispatchBins, effectBins;
+    std::atomic<bool> resetRequested { false };
+
+    // Audio thread only
+    double sampleRate = 44100.0;
+    double blockStart = 0.0;
+
+    static constexpr int kMaxPendingEvents = 64;
+    std::array<std::pair<Path, double>, kMaxPendingEvents> pending {};
+    int numPending = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ControlLatencyProfiler)
+};
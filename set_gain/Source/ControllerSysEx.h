@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    ControllerSysEx.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Bulk state exchange with the gain knob firmware, so both sides resync in
+// one round trip instead of waiting for CC refreshes.
+//
+//   F0 7D 01 01 F7                           state request (plugin -> device)
+//   F0 7D 01 02 ch n [cc value] * n F7       state dump (device -> plugin)
+//   F0 7D 01 03 ch n [cc value] * n F7       feedback dump (plugin -> device)
+//
+// 7D is the non-commercial manufacturer ID, 01 the product. Channels are
+// 0-15 on the wire. Parsing never allocates, so it can run on the MIDI thread.
+//
+// Shared with the gainPlugin project, which talks to the same firmware.
+namespace ControllerSysEx
+{
+    constexpr juce::uint8 kManufacturerId = 0x7d;
+    constexpr juce::uint8 kProductId = 0x01;
+
+    enum Command : juce::uint8
+    {
+        stateRequest = 0x01,
+        stateDump = 0x02,
+        feedbackDump = 0x03
+    };
+
+    // Most values one dump carries
+    constexpr int kMaxValues = 32;
+
+    // USB product name the firmware announces. Only ports with it in their
+    // name are sent these messages, as other gear may not ignore them.
+    constexpr const char* kDeviceName = "Gain Knob";
+
+    inline bool isControllerDevice(const juce::String& portName)
+    {
+        return portName.containsIgnoreCase(kDeviceName);
+    }
+
+    inline juce::MidiMessage createStateRequest()
+    {
+        const juce::uint8 body[] = { kManufacturerId, kProductId, stateRequest };
+        return juce::MidiMessage::createSysExMessage(body, (int) sizeof(body));
+    }
+
+    // Controllers and values (0-127) on one channel (1-16)
+    inline juce::MidiMessage createDump(Command command, int channel, const juce::uint8* controllers,
+                                        const juce::uint8* values, int numValues)
+    {
+        numValues = juce::jlimit(0, kMaxValues, numValues);
+
+        std::array<juce::uint8, 5 + 2 * kMaxValues> body {};
+        body[0] = kManufacturerId;
+        body[1] = kProductId;
+        body[2] = command;
+        body[3] = (juce::uint8) ((channel - 1) & 0x0f);
+        body[4] = (juce::uint8) numValues;
+
+        for (int i = 0; i < numValues; ++i)
+        {
+            body[(size_t) (5 + 2 * i)] = (juce::uint8) (controllers[i] & 0x7f);
+            body[(size_t) (6 + 2 * i)] = (juce::uint8) (values[i] & 0x7f);
+        }
+
+        return juce::MidiMessage::createSysExMessage(body.data(), 5 + 2 * numValues);
+    }
+
+    // Returns true if the message is one of ours with the given command
+    inline bool isCommand(const juce::MidiMessage& message, Command command)
+    {
+        if (! message.isSysEx() || message.getSysExDataSize() < 3)
+            return false;
+
+        const auto* data = message.getSysExData();
+        return data[0] == kManufacturerId && data[1] == kProductId && data[2] == command;
+    }
+
+    // Calls fn(channel 1-16, controller, value) for every value in a dump with
+    // the given command. Returns false if the message isn't such a dump.
+    template <typename Function>
+    bool forEachValue(const juce::MidiMessage& message, Command command, Function&& fn)
+    {
+        if (! isCommand(message, command) || message.getSysExDataSize() < 5)
+            return false;
+
+        const auto* data = message.getSysExData();
+        const int channel = (data[3] & 0x0f) + 1;
+        const int numValues = juce::jmin((int) data[4], (message.getSysExDataSize() - 5) / 2);
+
+        for (int i = 0; i < numValues; ++i)
+            fn(channel, (int) data[5 + 2 * i], (int) data[6 + 2 * i]);
+
+        return true;
+    }
+}
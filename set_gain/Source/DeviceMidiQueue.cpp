@@ -0,0 +1,183 @@
+/*
+  ==============================================================================
+
+    DeviceMidiQueue.cpp
+
+  ==============================================================================
+*/
+
+#include "DeviceMidiQueue.h"
+#include "RealtimeFifo.h"
+
+//==============================================================================
+namespace
+{
+    // Within this of the expected block time the block clock keeps free-running,
+    // which hides callback scheduling jitter; beyond it (stalls, transport
+    // restarts) it re-syncs to the system clock
+    constexpr double kResyncSeconds = 0.002;
+
+    double nowSeconds() { return juce::Time::getMillisecondCounterHiRes() * 0.001; }
+
+    template <size_t Size>
+    bool matchFirst(const std::array<juce::uint32, Size>& packed, std::array<bool, Size>& matched, int count, juce::uint32 key)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            if (! matched[(size_t) i] && packed[(size_t) i] == key)
+            {
+                matched[(size_t) i] = true;
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
+
+//==============================================================================
+void DeviceMidiQueue::prepareToPlay(double newSampleRate, int samplesPerBlock)
+{
+    sampleRate = newSampleRate;
+    blockDuration = samplesPerBlock / sampleRate;
+    windowEnd = 0.0;
+    numPending = 0;
+    numPrevious = 0;
+    numDeviceEvents = 0;
+
+    // Drop anything queued while stopped; only the reading side is touched,
+    // so the MIDI thread can keep pushing
+    fifo.read(fifo.getNumReady());
+}
+
+void DeviceMidiQueue::push(const juce::MidiMessage& message, int deviceSlot)
+{
+    // Stamped here rather than trusting the driver's timestamp, so every
+    // platform uses the same clock as renderNextBlock
+    pushEvent(message, deviceSlot, -1.0);
+}
+
+void DeviceMidiQueue::pushAt(const juce::MidiMessage& message, int deviceSlot, double timeSeconds)
+{
+    jassert(offline);
+    pushEvent(message, deviceSlot, timeSeconds);
+}
+
+void DeviceMidiQueue::pushEvent(const juce::MidiMessage& message, int deviceSlot, double time)
+{
+    if (message.getRawDataSize() > 3 || message.isSysEx())
+        return;
+
+    // Producers take turns so the FIFO stays in time order; the audio thread
+    // never takes this lock
+    const juce::SpinLock::ScopedLockType sl(pushLock);
+
+    if (time < 0.0)
+        time = nowSeconds();
+
+    // Full FIFO: drop the message rather than block the MIDI thread
+    RealtimeFifo::push(fifo, events, Event { time, pack(message.getRawData(), message.getRawDataSize()), deviceSlot });
+}
+
+//==============================================================================
+void DeviceMidiQueue::renderNextBlock(const juce::MidiBuffer& hostMidi, int numSamples)
+{
+    numHostDuplicates = 0;
+    hostDuplicateCursor = 0;
+
+    // This block plays back the device messages of the previous block period.
+    // Offline, time is the samples processed, so the clock never drifts.
+    const double expected = windowEnd + blockDuration;
+    const double now = offline ? expected : nowSeconds();
+    const bool inSync = std::abs(now - expected) < kResyncSeconds;
+    const double windowStart = inSync ? windowEnd : now - blockDuration;
+
+    windowEnd = inSync ? expected : now;
+    blockDuration = numSamples / sampleRate;
+
+    // Events are in time order, so take the prefix that falls in the window
+    numPending = 0;
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead(juce::jmin(fifo.getNumReady(), kMaxPerBlock), start1, size1, start2, size2);
+
+        const auto take = [&](int start, int size)
+        {
+            for (int i = start; i < start + size; ++i)
+            {
+                if (events[(size_t) i].time >= windowEnd)
+                    return false;
+
+                pending[(size_t) numPending] = events[(size_t) i].packed;
+                pendingTime[(size_t) numPending] = events[(size_t) i].time;
+                pendingSlot[(size_t) numPending] = events[(size_t) i].deviceSlot;
+                pendingMatched[(size_t) numPending] = false;
+                ++numPending;
+            }
+            return true;
+        };
+
+        if (take(start1, size1))
+            take(start2, size2);
+
+        fifo.finishedRead(numPending);
+    }
+
+    // A host message is either unique, or its device copy (in pending) is now
+    // dropped, or its device copy already went out with the previous block
+    int hostIndex = 0;
+
+    for (const auto metadata : hostMidi)
+    {
+        const auto key = metadata.numBytes <= 3 ? pack(metadata.data, metadata.numBytes) : 0;
+
+        if (key != 0 && ! matchFirst(pending, pendingMatched, numPending, key)
+            && matchFirst(previous, previousMatched, numPrevious, key))
+            hostDuplicates[(size_t) numHostDuplicates++] = hostIndex;
+
+        ++hostIndex;
+    }
+
+    numPrevious = 0;
+    numDeviceEvents = 0;
+
+    for (int i = 0; i < numPending; ++i)
+    {
+        if (pendingMatched[(size_t) i])
+            continue;
+
+        // Late arrivals (before the window) land at the start of the block
+        const int position = juce::jlimit(0, numSamples - 1,
+                                          juce::roundToInt((pendingTime[(size_t) i] - windowStart) * sampleRate));
+        deviceEvents[(size_t) numDeviceEvents++] = { pending[(size_t) i], position, pendingSlot[(size_t) i], pendingTime[(size_t) i] };
+
+        previous[(size_t) numPrevious] = pending[(size_t) i];
+        previousMatched[(size_t) numPrevious] = false;
+        ++numPrevious;
+    }
+}
+
+bool DeviceMidiQueue::isHostDuplicate(int hostIndex)
+{
+    while (hostDuplicateCursor < numHostDuplicates && hostDuplicates[(size_t) hostDuplicateCursor] < hostIndex)
+        ++hostDuplicateCursor;
+
+    return hostDuplicateCursor < numHostDuplicates && hostDuplicates[(size_t) hostDuplicateCursor] == hostIndex;
+}
+
+//==============================================================================
+juce::uint32 DeviceMidiQueue::pack(const juce::uint8* data, int size)
+{
+    juce::uint32 packed = (juce::uint32) size << 24;
+
+    for (int i = 0; i < size; ++i)
+        packed |= (juce::uint32) data[i] << (8 * i);
+
+    return packed;
+}
+
+juce::MidiMessage DeviceMidiQueue::DeviceEvent::getMessage() const
+{
+    const juce::uint8 data[3] = { (juce::uint8) packed, (juce::uint8) (packed >> 8), (juce::uint8) (packed >> 16) };
+    return juce::MidiMessage(data, (int) (packed >> 24), (double) samplePosition);
+}
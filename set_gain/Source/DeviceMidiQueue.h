@@ -0,0 +1,117 @@
+/*
+  ==============================================================================
+
+    DeviceMidiQueue.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Carries MIDI from directly opened devices into the audio callback with
+// sample-accurate timing, in the manner of juce::MidiMessageCollector.
+//
+// The MIDI thread pushes timestamped messages into a lock-free FIFO. At the
+// start of each block, the messages that arrived during the previous block
+// period are placed at the same relative position in this block, so device
+// control has a constant one-block latency instead of random timing.
+//
+// A host that routes the same device into the plugin's MIDI input delivers
+// each message twice; identical messages seen on both paths within a block
+// of each other are passed on once.
+//
+// Device messages keep the slot of the device they came from, so each can be
+// mapped through that device's own table.
+class DeviceMidiQueue
+{
+public:
+    //==============================================================================
+    static constexpr int kCapacity = 1024;
+
+    DeviceMidiQueue() = default;
+
+    // Call this in the plugin's prepareToPlay method
+    void prepareToPlay(double sampleRate, int samplesPerBlock);
+
+    // MIDI thread, or the capture player. The audio thread never waits on
+    // it. Only short messages are queued; SysEx is ignored.
+    void push(const juce::MidiMessage& message, int deviceSlot);
+    
+    // Offline rendering: the block clock follows the samples processed since
+    // prepareToPlay instead of the system clock, and messages are pushed with
+    // pushAt() at a time in seconds on that clock, before the block that
+    // covers it. Arrival times, and so latency figures, are on that clock too.
+    void setOffline(bool shouldRunOffline) { offline = shouldRunOffline; }
+    void pushAt(const juce::MidiMessage& message, int deviceSlot, double timeSeconds);
+
+    // Audio thread: works out the device messages for this block and which
+    // of the host messages duplicate them. The host buffer is only read.
+    void renderNextBlock(const juce::MidiBuffer& hostMidi, int numSamples);
+
+    // Audio thread, after renderNextBlock: true if the host message at this
+    // index (counted in buffer order) is a copy of a device message that was
+    // already passed on, and should be skipped. Call with rising indices.
+    bool isHostDuplicate(int hostIndex);
+
+    //==============================================================================
+    struct DeviceEvent
+    {
+        juce::uint32 packed = 0;
+        int samplePosition = 0;
+        int deviceSlot = 0;
+        double arrivalTime = 0.0;   // seconds, Time::getMillisecondCounterHiRes() clock
+
+        juce::MidiMessage getMessage() const;
+    };
+
+    // This block's device messages, in sample order. Host messages at the
+    // same position come first.
+    int getNumDeviceEvents() const { return numDeviceEvents; }
+    const DeviceEvent& getDeviceEvent(int index) const { return deviceEvents[(size_t) index]; }
+
+private:
+    //==============================================================================
+    struct Event
+    {
+        double time = 0.0;          // seconds, Time::getMillisecondCounterHiRes() clock
+        juce::uint32 packed = 0;    // bytes 0-2, size in the top byte
+        int deviceSlot = 0;
+    };
+
+    static juce::uint32 pack(const juce::uint8* data, int size);
+    void pushEvent(const juce::MidiMessage& message, int deviceSlot, double time);
+
+    juce::AbstractFifo fifo { kCapacity };
+    std::array<Event, kCapacity> events;
+    juce::SpinLock pushLock;
+
+    double sampleRate = 44100.0;
+    double blockDuration = 0.0;
+    double windowEnd = 0.0;
+    bool offline = false;
+
+    // Device messages pulled for this block and emitted in the previous one,
+    // kept for duplicate detection. Audio thread only.
+    static constexpr int kMaxPerBlock = 256;
+    std::array<juce::uint32, kMaxPerBlock> pending {};
+    std::array<double, kMaxPerBlock> pendingTime {};
+    std::array<int, kMaxPerBlock> pendingSlot {};
+    std::array<bool, kMaxPerBlock> pendingMatched {};
+    std::array<juce::uint32, kMaxPerBlock> previous {};
+    std::array<bool, kMaxPerBlock> previousMatched {};
+    int numPending = 0;
+    int numPrevious = 0;
+
+    std::array<DeviceEvent, kMaxPerBlock> deviceEvents;
+    int numDeviceEvents = 0;
+
+    // Indices of the host messages to skip, ascending; at most one per
+    // message of the previous block
+    std::array<int, kMaxPerBlock> hostDuplicates {};
+    int numHostDuplicates = 0;
+    int hostDuplicateCursor = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DeviceMidiQueue)
+};
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    DryWetMix.cpp
+
+  ==============================================================================
+*/
+
+#include "DryWetMix.h"
+
+//==============================================================================
+void DryWetMix::prepareToPlay(double sampleRate, int samplesPerBlock, int numChannels, int latencySamples)
+{
+    // Power-of-two length so wrapping is a mask; room for the latency plus
+    // the block being written
+    const int size = juce::nextPowerOfTwo(juce::jmax(1, latencySamples + samplesPerBlock));
+
+    delayLine.setSize(juce::jmax(1, numChannels), size);
+    delayLine.clear();
+    bufferMask = size - 1;
+    writePosition = 0;
+    blockStart = 0;
+    maxLatency = size - samplesPerBlock;
+    latency = latencySamples;
+
+    mixSmoothed.reset(sampleRate, 0.05);
+}
+
+void DryWetMix::setLatency(int latencySamples)
+{
+    // The delay line is only resized in prepareToPlay; a plugin that changes
+    // its latency is expected to be re-prepared by the host
+    jassert(latencySamples <= maxLatency);
+    latency = juce::jlimit(0, maxLatency, latencySamples);
+}
+
+void DryWetMix::pushDry(const juce::AudioBuffer<float>& buffer, int numChannels)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int size = delayLine.getNumSamples();
+
+    if (numSamples > size)
+        return; // bigger than prepared for, mixWet will leave the block wet
+
+    blockStart = writePosition;
+    const int firstPart = juce::jmin(numSamples, size - writePosition);
+
+    for (int ch = 0; ch < juce::jmin(numChannels, delayLine.getNumChannels()); ++ch)
+    {
+        delayLine.copyFrom(ch, writePosition, buffer, ch, 0, firstPart);
+
+        if (firstPart < numSamples)
+            delayLine.copyFrom(ch, 0, buffer, ch, firstPart, numSamples - firstPart);
+    }
+
+    writePosition = (writePosition + numSamples) & bufferMask;
+}
+
+void DryWetMix::mixWet(juce::AudioBuffer<float>& buffer, int numChannels, float mix)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int size = delayLine.getNumSamples();
+
+    mixSmoothed.setTargetValue(mix);
+    const float from = mixSmoothed.getCurrentValue();
+    const float to = mixSmoothed.skip(numSamples);
+
+    if ((from == 1.0f && to == 1.0f) || numSamples > size)
+        return;
+
+    // Equal-power gains at both ends of the block, ramped linearly in between
+    const auto halfPi = juce::MathConstants<float>::halfPi;
+    const float dry0 = std::cos(from * halfPi), dry1 = std::cos(to * halfPi);
+    const float wet0 = std::sin(from * halfPi), wet1 = std::sin(to * halfPi);
+    const float dryStep = (dry1 - dry0) / (float) numSamples;
+    const float wetStep = (wet1 - wet0) / (float) numSamples;
+
+    // The delayed dry block may wrap around the end of the delay line,
+    // so the one pass is split into at most two contiguous runs
+    const int readStart = (blockStart - latency) & bufferMask;
+    const int firstPart = juce::jmin(numSamples, size - readStart);
+
+    for (int ch = 0; ch < juce::jmin(numChannels, delayLine.getNumChannels()); ++ch)
+    {
+        auto* out = buffer.getWritePointer(ch);
+        const auto* dry = delayLine.getReadPointer(ch);
+
+        for (int i = 0; i < firstPart; ++i)
+            out[i] = out[i] * (wet0 + wetStep * (float) (i + 1))
+                   + dry[readStart + i] * (dry0 + dryStep * (float) (i + 1));
+
+        for (int i = firstPart; i < numSamples; ++i)
+            out[i] = out[i] * (wet0 + wetStep * (float) (i + 1))
+                   + dry[i - firstPart] * (dry0 + dryStep * (float) (i + 1));
+    }
+}
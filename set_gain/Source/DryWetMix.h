@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    DryWetMix.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Parallel dry/wet mix with the dry path delayed by the plugin's reported
+// latency, so the two paths line up and don't comb-filter. The crossfade
+// is equal-power (cos/sin) and the mix itself is a single pass that reads
+// the delayed dry straight out of the delay line.
+//
+// None of the current stages add latency, so the plugin reports 0 and the
+// dry path is not delayed; the compensation only comes into play once a
+// stage that looks ahead calls setLatencySamples().
+class DryWetMix
+{
+public:
+    //==============================================================================
+    DryWetMix() = default;
+
+    // Call this in the plugin's prepareToPlay method, with the latency the
+    // plugin currently reports. The delay line is sized for it.
+    void prepareToPlay(double sampleRate, int samplesPerBlock, int numChannels, int latencySamples);
+
+    // Audio thread. Keep in sync with getLatencySamples() every block.
+    void setLatency(int latencySamples);
+
+    // Audio thread: store the dry input before anything processes the buffer
+    void pushDry(const juce::AudioBuffer<float>& buffer, int numChannels);
+
+    // Audio thread: mix the delayed dry back into the processed buffer.
+    // mix is 0 for fully dry, 1 for fully wet.
+    void mixWet(juce::AudioBuffer<float>& buffer, int numChannels, float mix);
+
+private:
+    //==============================================================================
+    juce::AudioBuffer<float> delayLine;
+    int bufferMask = 0;
+    int writePosition = 0;
+    int blockStart = 0;
+    int maxLatency = 0;
+    int latency = 0;
+
+    juce::SmoothedValue<float> mixSmoothed { 1.0f };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(DryWetMix)
+};
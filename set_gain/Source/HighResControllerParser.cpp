@@ -0,0 +1,163 @@
+/*
+  ==============================================================================
+
+    HighResControllerParser.cpp
+
+  ==============================================================================
+*/
+
+#include "HighResControllerParser.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int kDataEntryMsb = 6;
+    constexpr int kDataEntryLsb = 38;
+    constexpr int kDataIncrement = 96;
+    constexpr int kDataDecrement = 97;
+    constexpr int kNrpnLsb = 98;
+    constexpr int kNrpnMsb = 99;
+    constexpr int kRpnLsb = 100;
+    constexpr int kRpnMsb = 101;
+}
+
+//==============================================================================
+HighResControllerParser::HighResControllerParser()
+{
+    reset();
+}
+
+void HighResControllerParser::reset()
+{
+    for (auto& state : channels)
+        state = ChannelState();
+}
+
+bool HighResControllerParser::process(const juce::MidiMessage& message, Event& event)
+{
+    if (! message.isController())
+        return false;
+
+    return process(message.getChannel(), message.getControllerNumber(), message.getControllerValue(), event);
+}
+
+bool HighResControllerParser::process(int channel, int controller, int value, Event& event)
+{
+    if (! juce::isPositiveAndBelow(channel - 1, (int) channels.size())
+        || ! juce::isPositiveAndBelow(controller, 128)
+        || ! juce::isPositiveAndBelow(value, 128))
+        return false;
+
+    auto& state = channels[(size_t) channel - 1];
+
+    switch (controller)
+    {
+        case kNrpnMsb:  selectParameter(state, false, value, state.isRpn ? kNoParameter : state.parameterLsb); return false;
+        case kNrpnLsb:  selectParameter(state, false, state.isRpn ? kNoParameter : state.parameterMsb, value); return false;
+        case kRpnMsb:   selectParameter(state, true, value, state.isRpn ? state.parameterLsb : kNoParameter); return false;
+        case kRpnLsb:   selectParameter(state, true, state.isRpn ? state.parameterMsb : kNoParameter, value); return false;
+
+        case kDataIncrement:
+        case kDataDecrement:
+        {
+            if (! isParameterSelected(state))
+                break;
+
+            // Steps by one LSB once the sender has shown it uses them, otherwise by one MSB
+            const int step = state.dataHasLsb ? 1 : 128;
+            const int current = (state.dataMsb << 7) | state.dataLsb;
+            const int next = juce::jlimit(0, kMaxValue, current + (controller == kDataIncrement ? step : -step));
+
+            state.dataMsb = next >> 7;
+            state.dataLsb = next & 0x7f;
+            return makeDataEvent(state, channel, event);
+        }
+
+        case kDataEntryMsb:
+            if (! isParameterSelected(state))
+                break;
+
+            // A new MSB invalidates the held LSB: the sender follows with a fresh
+            // LSB if it has one, and until then the value is MSB * 128
+            state.dataMsb = value;
+            state.dataLsb = 0;
+            return makeDataEvent(state, channel, event);
+
+        case kDataEntryLsb:
+            if (! isParameterSelected(state))
+                break;
+
+            state.dataLsb = value;
+            state.dataHasLsb = true;
+            return makeDataEvent(state, channel, event);
+
+        default:
+            break;
+    }
+
+    event.type = Type::controller;
+    event.channel = channel;
+
+    if (controller < 32)
+    {
+        state.msb[(size_t) controller] = (juce::uint8) value;
+        state.lsb[(size_t) controller] = 0;
+
+        event.number = controller;
+        event.value = (state.hasLsb >> controller) & 1 ? value << 7 : scale7Bit(value);
+        return true;
+    }
+
+    if (controller < 64)
+    {
+        const int msbController = controller - 32;
+        state.lsb[(size_t) msbController] = (juce::uint8) value;
+        state.hasLsb |= 1u << msbController;
+
+        event.number = msbController;
+        event.value = (state.msb[(size_t) msbController] << 7) | value;
+        return true;
+    }
+
+    event.number = controller;
+    event.value = scale7Bit(value);
+    return true;
+}
+
+//==============================================================================
+bool HighResControllerParser::isParameterSelected(const ChannelState& state)
+{
+    // Data entry belongs to the sequence as soon as either half has arrived
+    return state.parameterMsb != kNoParameter || state.parameterLsb != kNoParameter;
+}
+
+void HighResControllerParser::selectParameter(ChannelState& state, bool rpn, int msb, int lsb)
+{
+    // 127/127 is the "null" parameter that senders use to close a sequence
+    if (msb == 127 && lsb == 127)
+        msb = lsb = kNoParameter;
+
+    if (state.isRpn == rpn && state.parameterMsb == msb && state.parameterLsb == lsb)
+        return;
+
+    // Switching between NRPN and RPN invalidates the half already received
+    state.isRpn = rpn;
+    state.parameterMsb = msb;
+    state.parameterLsb = lsb;
+    state.dataMsb = 0;
+    state.dataLsb = 0;
+    state.dataHasLsb = false;
+}
+
+bool HighResControllerParser::makeDataEvent(const ChannelState& state, int channel, Event& event)
+{
+    // A selection with one half still missing isn't a parameter yet
+    if (state.parameterMsb == kNoParameter || state.parameterLsb == kNoParameter)
+        return false;
+
+    event.type = state.isRpn ? Type::rpn : Type::nrpn;
+    event.channel = channel;
+    event.number = (state.parameterMsb << 7) | state.parameterLsb;
+    event.value = state.dataHasLsb ? (state.dataMsb << 7) | state.dataLsb : scale7Bit(state.dataMsb);
+    return true;
+}
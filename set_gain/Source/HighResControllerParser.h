@@ -0,0 +1,77 @@
+/*
+  ==============================================================================
+
+    HighResControllerParser.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Turns raw CC messages into 14-bit controller values. CC 0-31 are paired
+// with their LSB partners (CC 32-63), and NRPN/RPN selection plus data
+// entry / increment / decrement are decoded into a single parameter event.
+//
+// Each MIDI channel has its own small state machine, so interleaved streams
+// on different channels don't disturb each other. Nothing allocates; one
+// instance must only be fed from one thread.
+class HighResControllerParser
+{
+public:
+    //==============================================================================
+    static constexpr int kMaxValue = 16383;
+
+    enum class Type { controller, nrpn, rpn };
+
+    struct Event
+    {
+        Type type = Type::controller;
+        int channel = 1;            // 1-16
+        int number = 0;             // CC number, or the 14-bit NRPN/RPN number
+        int value = 0;              // 0 - kMaxValue
+
+        float getNormalised() const { return (float) value / (float) kMaxValue; }
+    };
+
+    //==============================================================================
+    HighResControllerParser();
+
+    void reset();
+
+    // Returns true if the message produced an event. NRPN/RPN selection CCs
+    // (98-101) never do, nor does data entry before the selection is complete.
+    bool process(const juce::MidiMessage& message, Event& event);
+    bool process(int channel, int controller, int value, Event& event);
+
+private:
+    //==============================================================================
+    static constexpr int kNoParameter = -1;
+
+    struct ChannelState
+    {
+        std::array<juce::uint8, 32> msb {};
+        std::array<juce::uint8, 32> lsb {};
+        juce::uint32 hasLsb = 0;    // bit per controller once its LSB has been seen
+
+        int parameterMsb = kNoParameter;
+        int parameterLsb = kNoParameter;
+        bool isRpn = false;
+
+        int dataMsb = 0;
+        int dataLsb = 0;
+        bool dataHasLsb = false;
+    };
+
+    // Controllers that never send an LSB still reach the full range
+    static int scale7Bit(int value) { return (value * kMaxValue + 63) / 127; }
+
+    static bool isParameterSelected(const ChannelState& state);
+    static void selectParameter(ChannelState& state, bool rpn, int msb, int lsb);
+    static bool makeDataEvent(const ChannelState& state, int channel, Event& event);
+
+    std::array<ChannelState, 16> channels;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HighResControllerParser)
+};
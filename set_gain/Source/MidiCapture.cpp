@@ -0,0 +1,422 @@
+/*
+  ==============================================================================
+
+    MidiCapture.cpp
+
+  ==============================================================================
+*/
+
+#include "MidiCapture.h"
+#include "RealtimeFifo.h"
+
+//==============================================================================
+namespace
+{
+    juce::int64 nowMicros()
+    {
+        return (juce::int64) (juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks()) * 1.0e6);
+    }
+
+    juce::uint32 pack(const juce::uint8* bytes, int size)
+    {
+        juce::uint32 packed = (juce::uint32) size << 24;
+        for (int i = 0; i < size; ++i)
+            packed |= (juce::uint32) bytes[i] << (8 * i);
+        return packed;
+    }
+
+    void writeVarint(juce::OutputStream& out, juce::uint64 value)
+    {
+        while (value >= 0x80)
+        {
+            out.writeByte((char) ((value & 0x7f) | 0x80));
+            value >>= 7;
+        }
+        out.writeByte((char) value);
+    }
+
+    bool readVarint(juce::InputStream& in, juce::uint64& value)
+    {
+        value = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (in.isExhausted())
+                return false;
+
+            const auto byte = (juce::uint8) in.readByte();
+            value |= (juce::uint64) (byte & 0x7f) << shift;
+
+            if ((byte & 0x80) == 0)
+                return true;
+        }
+        return false;
+    }
+
+    constexpr juce::uint8 kHostFlag = 1;
+    constexpr juce::uint8 kRunningStatusFlag = 2;
+}
+
+//==============================================================================
+MidiCaptureRecorder::MidiCaptureRecorder()
+    : juce::Thread("MIDI capture writer")
+{
+}
+
+MidiCaptureRecorder::~MidiCaptureRecorder()
+{
+    stop();
+}
+
+bool MidiCaptureRecorder::start(const juce::File& file)
+{
+    stop();
+
+    // Anything left from a previous session (pushed after it stopped) is stale
+    deviceQueue.fifo.read(deviceQueue.fifo.getNumReady());
+    hostQueue.fifo.read(hostQueue.fifo.getNumReady());
+
+    file.deleteFile();
+    stream = std::make_unique<juce::FileOutputStream>(file);
+
+    if (stream->failedToOpen())
+    {
+        stream.reset();
+        return false;
+    }
+
+    stream->write(MidiCaptureFormat::kMagic, sizeof(MidiCaptureFormat::kMagic));
+    stream->writeByte((char) MidiCaptureFormat::kVersion);
+    stream->writeInt64(juce::Time::currentTimeMillis());
+
+    lastTimeMicros = nowMicros();
+    lastStatus = {};
+    numDropped = 0;
+
+    recording = true;
+    startThread();
+    return true;
+}
+
+void MidiCaptureRecorder::stop()
+{
+    if (stream == nullptr)
+        return;
+
+    recording = false;
+    stopThread(1000);
+
+    // The writer has stopped, so this thread can take the last events
+    writePending();
+    stream->flush();
+    stream.reset();
+}
+
+//==============================================================================
+void MidiCaptureRecorder::recordDevice(const juce::MidiMessage& message, int deviceSlot)
+{
+    if (! isRecording() || message.getRawDataSize() > 3 || message.isSysEx())
+        return;
+
+    push(deviceQueue, { nowMicros(), pack(message.getRawData(), message.getRawDataSize()), deviceSlot });
+}
+
+void MidiCaptureRecorder::recordHost(const juce::MidiBuffer& buffer)
+{
+    if (! isRecording() || buffer.isEmpty())
+        return;
+
+    // The whole block shares its arrival time; the sample position says where
+    // in the block each event was
+    const auto time = nowMicros();
+
+    for (const auto metadata : buffer)
+        if (metadata.numBytes <= 3)
+            push(hostQueue, { time, pack(metadata.data, metadata.numBytes), metadata.samplePosition });
+}
+
+void MidiCaptureRecorder::push(Queue& queue, const Record& record)
+{
+    if (! RealtimeFifo::push(queue.fifo, queue.records, record))
+        numDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void MidiCaptureRecorder::run()
+{
+    while (! threadShouldExit())
+    {
+        writePending();
+        wait(50);
+    }
+}
+
+void MidiCaptureRecorder::writePending()
+{
+    int d1, dn1, d2, dn2, h1, hn1, h2, hn2;
+    deviceQueue.fifo.prepareToRead(deviceQueue.fifo.getNumReady(), d1, dn1, d2, dn2);
+    hostQueue.fifo.prepareToRead(hostQueue.fifo.getNumReady(), h1, hn1, h2, hn2);
+
+    const auto at = [](const Queue& queue, int start1, int size1, int start2, int index) -> const Record&
+    {
+        return queue.records[(size_t) (index < size1 ? start1 + index : start2 + index - size1)];
+    };
+
+    // Both queues are in time order; merge them so the deltas never go negative
+    const int numDevice = dn1 + dn2;
+    const int numHost = hn1 + hn2;
+    int device = 0, host = 0;
+
+    while (device < numDevice || host < numHost)
+    {
+        const bool takeDevice = host >= numHost
+                             || (device < numDevice && at(deviceQueue, d1, dn1, d2, device).timeMicros
+                                                       <= at(hostQueue, h1, hn1, h2, host).timeMicros);
+
+        if (takeDevice)
+            writeRecord(at(deviceQueue, d1, dn1, d2, device++), MidiCaptureFormat::Source::device);
+        else
+            writeRecord(at(hostQueue, h1, hn1, h2, host++), MidiCaptureFormat::Source::host);
+    }
+
+    deviceQueue.fifo.finishedRead(numDevice);
+    hostQueue.fifo.finishedRead(numHost);
+}
+
+void MidiCaptureRecorder::writeRecord(const Record& record, MidiCaptureFormat::Source source)
+{
+    const auto sourceIndex = (size_t) source;
+    const auto status = (juce::uint8) record.packed;
+    const int size = (int) (record.packed >> 24);
+    const bool runningStatus = status == lastStatus[sourceIndex];
+
+    writeVarint(*stream, (juce::uint64) juce::jmax((juce::int64) 0, record.timeMicros - lastTimeMicros));
+    stream->writeByte((char) ((source == MidiCaptureFormat::Source::host ? kHostFlag : 0)
+                              | (runningStatus ? kRunningStatusFlag : 0)));
+
+    // Host: position in the block, device: slot
+    writeVarint(*stream, (juce::uint64) juce::jmax(0, record.samplePosition));
+
+    for (int i = runningStatus ? 1 : 0; i < size; ++i)
+        stream->writeByte((char) (record.packed >> (8 * i)));
+
+    lastTimeMicros = juce::jmax(lastTimeMicros, record.timeMicros);
+    lastStatus[sourceIndex] = status;
+}
+
+//==============================================================================
+MidiCaptureReplayer::MidiCaptureReplayer(const juce::File& file)
+{
+    if (! file.loadFileAsData(data) || data.getSize() < 13)
+        return;
+
+    input = std::make_unique<juce::MemoryInputStream>(data, false);
+
+    char magic[4];
+    input->read(magic, sizeof(magic));
+
+    version = (juce::uint8) input->readByte();
+
+    if (std::memcmp(magic, MidiCaptureFormat::kMagic, sizeof(magic)) != 0 || version < 1 || version > MidiCaptureFormat::kVersion)
+        return;
+
+    startTime = juce::Time(input->readInt64());
+    firstRecordOffset = input->getPosition();
+    valid = true;
+}
+
+void MidiCaptureReplayer::rewind()
+{
+    if (! valid)
+        return;
+
+    input->setPosition(firstRecordOffset);
+    timeMicros = 0;
+    lastStatus = {};
+}
+
+bool MidiCaptureReplayer::readNext(Event& event)
+{
+    juce::uint64 delta = 0, samplePosition = 0, deviceSlot = 0;
+
+    if (! valid || ! readVarint(*input, delta) || input->isExhausted())
+        return false;
+
+    const auto flags = (juce::uint8) input->readByte();
+    const auto source = (flags & kHostFlag) != 0 ? MidiCaptureFormat::Source::host : MidiCaptureFormat::Source::device;
+    const auto sourceIndex = (size_t) source;
+
+    if (source == MidiCaptureFormat::Source::host && ! readVarint(*input, samplePosition))
+        return false;
+
+    // Version 1 didn't record which device an event came from
+    if (source == MidiCaptureFormat::Source::device && version >= 2 && ! readVarint(*input, deviceSlot))
+        return false;
+
+    juce::uint8 bytes[3] = { lastStatus[sourceIndex], 0, 0 };
+    if ((flags & kRunningStatusFlag) == 0)
+        bytes[0] = (juce::uint8) input->readByte();
+
+    if (bytes[0] < 0x80)
+        return false;
+
+    const int size = juce::MidiMessage::getMessageLengthFromFirstByte(bytes[0]);
+    if (size < 1 || size > 3)
+        return false;
+
+    for (int i = 1; i < size; ++i)
+        bytes[i] = (juce::uint8) input->readByte();
+
+    timeMicros += (juce::int64) delta;
+    lastStatus[sourceIndex] = bytes[0];
+
+    event.timeSeconds = (double) timeMicros * 1.0e-6;
+    event.source = source;
+    event.samplePosition = (int) samplePosition;
+    event.deviceSlot = (int) deviceSlot;
+    event.message = juce::MidiMessage(bytes, size, event.timeSeconds);
+    return true;
+}
+
+//==============================================================================
+MidiCapturePlayer::MidiCapturePlayer(DeviceMidiQueue& queue)
+    : juce::Thread("MIDI capture player"),
+      deviceQueue(queue)
+{
+}
+
+MidiCapturePlayer::~MidiCapturePlayer()
+{
+    stop();
+}
+
+bool MidiCapturePlayer::start(const juce::File& file)
+{
+    stop();
+
+    replayer = std::make_unique<MidiCaptureReplayer>(file);
+    if (! replayer->isValid())
+    {
+        replayer.reset();
+        return false;
+    }
+
+    playing = true;
+    startThread();
+    return true;
+}
+
+void MidiCapturePlayer::stop()
+{
+    stopThread(1000);
+    playing = false;
+    replayer.reset();
+}
+
+//==============================================================================
+void MidiCapturePlayer::run()
+{
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    double firstEventSeconds = -1.0;
+    MidiCaptureReplayer::Event event;
+
+    while (! threadShouldExit() && replayer->readNext(event))
+    {
+        if (firstEventSeconds < 0.0)
+            firstEventSeconds = event.timeSeconds;
+
+        // Wait in short steps, so stopping doesn't hang on a long gap
+        const double dueMs = startMs + (event.timeSeconds - firstEventSeconds) * 1000.0;
+        for (double now = juce::Time::getMillisecondCounterHiRes(); now < dueMs && ! threadShouldExit();
+             now = juce::Time::getMillisecondCounterHiRes())
+            wait(juce::jlimit(1, 50, (int) (dueMs - now)));
+
+        if (threadShouldExit())
+            break;
+
+        if (event.source == MidiCaptureFormat::Source::device)
+            deviceQueue.push(event.message, event.deviceSlot);
+        else
+            pushHost(event);
+    }
+
+    playing = false;
+}
+
+int MidiCapturePlayer::renderOffline(const juce::File& file, juce::AudioProcessor& processor)
+{
+    stop();
+
+    MidiCaptureReplayer reader(file);
+    if (! reader.isValid())
+        return -1;
+
+    const double sampleRate = processor.getSampleRate();
+    const int blockSize = processor.getBlockSize();
+    jassert(sampleRate > 0.0 && blockSize > 0);
+
+    juce::AudioBuffer<float> audio(juce::jmax(processor.getTotalNumInputChannels(), processor.getTotalNumOutputChannels()), blockSize);
+    juce::MidiBuffer hostMidi;
+
+    deviceQueue.setOffline(true);
+    processor.prepareToPlay(sampleRate, blockSize);
+
+    MidiCaptureReplayer::Event event;
+    bool hasEvent = reader.readNext(event);
+    const double firstEventSeconds = hasEvent ? event.timeSeconds : 0.0;
+    int numEvents = 0;
+
+    // Each block is given the events recorded during its span; device events
+    // play back one block later, as they do live, so one more block follows
+    for (juce::int64 block = 0; hasEvent; ++block)
+    {
+        const double blockEnd = (double) ((block + 1) * blockSize) / sampleRate;
+
+        for (; hasEvent && event.timeSeconds - firstEventSeconds < blockEnd; hasEvent = reader.readNext(event), ++numEvents)
+        {
+            if (event.source == MidiCaptureFormat::Source::device)
+                deviceQueue.pushAt(event.message, event.deviceSlot, event.timeSeconds - firstEventSeconds);
+            else
+                pushHost(event);
+        }
+
+        audio.clear();
+        hostMidi.clear();
+        processor.processBlock(audio, hostMidi);
+    }
+
+    audio.clear();
+    hostMidi.clear();
+    processor.processBlock(audio, hostMidi);
+
+    deviceQueue.setOffline(false);
+    return numEvents;
+}
+
+void MidiCapturePlayer::pushHost(const MidiCaptureReplayer::Event& event)
+{
+    const HostEvent hostEvent { pack(event.message.getRawData(), event.message.getRawDataSize()), event.samplePosition };
+
+    // Full: the audio thread isn't running, drop rather than wait
+    RealtimeFifo::push(hostFifo, hostEvents, hostEvent);
+}
+
+void MidiCapturePlayer::renderNextBlock(juce::MidiBuffer& hostMidi, int numSamples)
+{
+    // Events recorded in one block were pushed together, so they land in the same one
+    const auto scope = hostFifo.read(hostFifo.getNumReady());
+
+    const auto add = [this, &hostMidi, numSamples](int start, int size)
+    {
+        for (int i = start; i < start + size; ++i)
+        {
+            const auto& hostEvent = hostEvents[(size_t) i];
+            const juce::uint8 bytes[3] = { (juce::uint8) hostEvent.packed, (juce::uint8) (hostEvent.packed >> 8),
+                                           (juce::uint8) (hostEvent.packed >> 16) };
+
+            hostMidi.addEvent(bytes, (int) (hostEvent.packed >> 24), juce::jlimit(0, juce::jmax(0, numSamples - 1), hostEvent.samplePosition));
+        }
+    };
+
+    add(scope.startIndex1, scope.blockSize1);
+    add(scope.startIndex2, scope.blockSize2);
+}
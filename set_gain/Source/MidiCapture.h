@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+    MidiCapture.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "DeviceMidiQueue.h"
+
+//==============================================================================
+// File layout: "VMSM", version byte, int64 start time (ms since epoch, LE),
+// then one record per event:
+//   varint  microseconds since the previous record
+//   byte    bit 0 source (0 device, 1 host), bit 1 running status
+//   varint  sample position in the block (host events only)
+//   varint  device slot (device events only, version 2 on)
+//   bytes   status (unless running status) and data bytes
+//
+// A CC costs 4-5 bytes. Only short messages are captured, like the device
+// queue; SysEx is not recorded.
+namespace MidiCaptureFormat
+{
+    enum class Source : juce::uint8 { device = 0, host = 1 };
+
+    constexpr char kMagic[4] = { 'V', 'M', 'S', 'M' };
+    constexpr juce::uint8 kVersion = 2;
+}
+
+//==============================================================================
+// Logs every incoming MIDI event with a microsecond timestamp and its
+// source. The MIDI and audio threads hand events over through wait-free
+// FIFOs; a background thread merges them in time order and writes the file.
+class MidiCaptureRecorder : private juce::Thread
+{
+public:
+    //==============================================================================
+    static constexpr int kCapacity = 4096;
+
+    MidiCaptureRecorder();
+    ~MidiCaptureRecorder() override;
+
+    // Message thread
+    bool start(const juce::File& file);
+    void stop();
+    bool isRecording() const { return recording.load(std::memory_order_relaxed); }
+
+    // MIDI thread / audio thread, wait-free. Nothing happens unless recording.
+    void recordDevice(const juce::MidiMessage& message, int deviceSlot);
+    void recordHost(const juce::MidiBuffer& buffer);
+
+    // Events lost because the writer fell behind
+    int getNumDropped() const { return numDropped.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    struct Record
+    {
+        juce::int64 timeMicros = 0;
+        juce::uint32 packed = 0;    // bytes 0-2, size in the top byte
+        int samplePosition = 0;     // host: position in the block, device: slot
+    };
+
+    struct Queue
+    {
+        juce::AbstractFifo fifo { kCapacity };
+        std::array<Record, kCapacity> records;
+    };
+
+    void run() override;
+    void push(Queue& queue, const Record& record);
+    void writePending();
+    void writeRecord(const Record& record, MidiCaptureFormat::Source source);
+
+    Queue deviceQueue, hostQueue;
+    std::atomic<bool> recording { false };
+    std::atomic<int> numDropped { 0 };
+
+    // Writer side
+    std::unique_ptr<juce::FileOutputStream> stream;
+    juce::int64 lastTimeMicros = 0;
+    std::array<juce::uint8, 2> lastStatus {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiCaptureRecorder)
+};
+
+//==============================================================================
+// Reads a capture back event by event
+class MidiCaptureReplayer
+{
+public:
+    //==============================================================================
+    struct Event
+    {
+        double timeSeconds = 0.0;   // since the recording started
+        MidiCaptureFormat::Source source = MidiCaptureFormat::Source::device;
+        int samplePosition = 0;     // host events
+        int deviceSlot = 0;         // device events
+        juce::MidiMessage message;
+    };
+
+    explicit MidiCaptureReplayer(const juce::File& file);
+
+    bool isValid() const { return valid; }
+    juce::Time getStartTime() const { return startTime; }
+
+    bool readNext(Event& event);
+    void rewind();
+
+private:
+    //==============================================================================
+    juce::MemoryBlock data;
+    std::unique_ptr<juce::MemoryInputStream> input;
+    juce::int64 firstRecordOffset = 0;
+    juce::Time startTime;
+    juce::uint8 version = 0;
+    bool valid = false;
+
+    juce::int64 timeMicros = 0;
+    std::array<juce::uint8, 2> lastStatus {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiCaptureReplayer)
+};
+
+//==============================================================================
+// Plays a capture into a running processor at the original speed. Device
+// events go into its DeviceMidiQueue with the slot they came from, so they
+// meet the same per-device tables, coalescing and timing as live input. Host
+// events are handed to the audio thread, which adds them to the next block's
+// host MIDI at their recorded sample position.
+class MidiCapturePlayer : private juce::Thread
+{
+public:
+    //==============================================================================
+    static constexpr int kCapacity = 1024;
+
+    explicit MidiCapturePlayer(DeviceMidiQueue& deviceQueue);
+    ~MidiCapturePlayer() override;
+
+    // Message thread
+    bool start(const juce::File& file);
+    void stop();
+    bool isPlaying() const { return playing.load(std::memory_order_relaxed); }
+
+    // Audio thread, before the block's MIDI is read. The plugin wrappers
+    // reserve room in the host buffer, so adding a few events doesn't allocate.
+    void renderNextBlock(juce::MidiBuffer& hostMidi, int numSamples);
+    
+    // Offline, on the calling thread: plays the whole capture through the
+    // processor that owns this player, calling processBlock block by block
+    // with no waiting, so as fast as it runs. Events keep their recorded
+    // timing in samples. Meant for a scratch instance that no host or device
+    // is driving; it's prepared again at its current rate and block size.
+    // Returns the number of events played, or -1 if the file can't be read.
+    int renderOffline(const juce::File& file, juce::AudioProcessor& processor);
+
+private:
+    //==============================================================================
+    struct HostEvent
+    {
+        juce::uint32 packed = 0;    // bytes 0-2, size in the top byte
+        int samplePosition = 0;
+    };
+
+    void run() override;
+    void pushHost(const MidiCaptureReplayer::Event& event);
+
+    DeviceMidiQueue& deviceQueue;
+    std::unique_ptr<MidiCaptureReplayer> replayer;
+    std::atomic<bool> playing { false };
+
+    juce::AbstractFifo hostFifo { kCapacity };
+    std::array<HostEvent, kCapacity> hostEvents;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiCapturePlayer)
+};
@@ -0,0 +1,305 @@
+/*
+  ==============================================================================
+
+    MidiDeviceService.cpp
+
+  ==============================================================================
+*/
+
+#include "MidiDeviceService.h"
+#include "ControllerSysEx.h"
+
+//==============================================================================
+MidiDeviceService::MidiDeviceService()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    for (auto& values : controllerValues)
+        values.fill(-1);
+
+    daemon.addChangeListener(this);
+
+    // A control daemon owns the hardware; its values come in through
+    // SharedControlReader and no device API is touched until it goes away
+    if (! daemon.isConnected())
+        openDevices();
+}
+
+MidiDeviceService::~MidiDeviceService()
+{
+    daemon.removeChangeListener(this);
+    closeDevices();
+}
+
+void MidiDeviceService::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    if (daemon.isConnected())
+    {
+        DBG("Control daemon running, closing MIDI inputs");
+        closeDevices();
+        sendSynchronousChangeMessage();
+    }
+    else
+    {
+        DBG("Control daemon gone, opening MIDI inputs");
+        openDevices();
+    }
+}
+
+void MidiDeviceService::openDevices()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    refreshDevices();
+    deviceListConnection = juce::MidiDeviceListConnection::make([this]()
+    {
+        numDeviceChanges.fetch_add(1, std::memory_order_relaxed);
+        refreshDevices();
+    });
+}
+
+void MidiDeviceService::closeDevices()
+{
+    // Stop listening for changes before the inputs go away
+    deviceListConnection.reset();
+
+    for (auto& open : openInputs)
+        if (open != nullptr)
+            open->input->stop();
+
+    for (auto& open : openInputs)
+    {
+        if (open != nullptr)
+            heartbeats[(size_t) open->slot].setOpen(false);
+
+        open.reset();
+    }
+
+    numOpenDevices.store(0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void MidiDeviceService::Callback::handleDeviceState(int deviceSlot, const ControllerValues& values)
+{
+    for (int i = 0; i < kNumControllerSlots; ++i)
+        if (values[(size_t) i] >= 0)
+            handleDeviceMidi(deviceSlot, juce::MidiMessage::controllerEvent(i / 128 + 1, i % 128, values[(size_t) i]));
+}
+
+//==============================================================================
+void MidiDeviceService::addCallback(Callback* callback)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    const juce::ScopedLock sl(callbackLock);
+    if (callbacks.contains(callback))
+        return;
+
+    callbacks.add(callback);
+    sendDeviceStates(callback);
+}
+
+void MidiDeviceService::sendDeviceStates(Callback* callback)
+{
+    // Held against the MIDI thread, so nothing arrives in between and the
+    // callback sees these before any newer value
+    const juce::ScopedLock sl(callbackLock);
+
+    for (int slot = 0; slot < kMaxDevices; ++slot)
+        if (heartbeats[(size_t) slot].isOpen())
+            callback->handleDeviceState(slot, controllerValues[(size_t) slot]);
+}
+
+void MidiDeviceService::removeCallback(Callback* callback)
+{
+    // Once this returns the callback is guaranteed not to be running
+    const juce::ScopedLock sl(callbackLock);
+    callbacks.removeFirstMatchingValue(callback);
+}
+
+juce::MidiDeviceInfo MidiDeviceService::getDeviceInfo(int deviceSlot) const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    if (! juce::isPositiveAndBelow(deviceSlot, kMaxDevices) || openInputs[(size_t) deviceSlot] == nullptr)
+        return {};
+
+    return openInputs[(size_t) deviceSlot]->input->getDeviceInfo();
+}
+
+void MidiDeviceService::requestState(const juce::MidiDeviceInfo& input)
+{
+    // Anything else is never sent our private SysEx
+    if (! ControllerSysEx::isControllerDevice(input.name))
+        return;
+
+    // USB devices show up as an input and an output with the same name. The
+    // output is only held for the one message, so it's free for anything
+    // else that wants it (e.g. a feedback sender).
+    for (const auto& output : juce::MidiOutput::getAvailableDevices())
+    {
+        if (output.name != input.name)
+            continue;
+
+        if (auto device = juce::MidiOutput::openDevice(output.identifier))
+            device->sendMessageNow(ControllerSysEx::createStateRequest());
+
+        return;
+    }
+}
+
+int MidiDeviceService::getNumConnectedDevices() const
+{
+    const auto timeout = sensingTimeoutMs.load(std::memory_order_relaxed);
+
+    return (int) std::count_if(heartbeats.begin(), heartbeats.end(),
+                               [timeout](const auto& heartbeat) { return heartbeat.isConnected(timeout); });
+}
+
+void MidiDeviceService::deliver(int deviceSlot, const juce::MidiMessage& message)
+{
+    if (heartbeats[(size_t) deviceSlot].messageReceived(message))
+        return;
+
+    // Held only by the MIDI thread and briefly by (un)subscribing instances,
+    // never by the audio thread
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+
+    {
+        const juce::ScopedLock sl(callbackLock);
+        rememberValues(deviceSlot, message);
+
+        for (auto* callback : callbacks)
+            callback->handleDeviceMidi(deviceSlot, message);
+    }
+
+    const auto ticks = juce::Time::getHighResolutionTicks() - startTicks;
+    numMessages.fetch_add(1, std::memory_order_relaxed);
+    callbackTicksTotal.fetch_add(ticks, std::memory_order_relaxed);
+
+    // Not a CAS loop: a race between two input threads only loses one sample
+    if (ticks > callbackTicksMax.load(std::memory_order_relaxed))
+        callbackTicksMax.store(ticks, std::memory_order_relaxed);
+}
+
+void MidiDeviceService::rememberValues(int deviceSlot, const juce::MidiMessage& message)
+{
+    auto& values = controllerValues[(size_t) deviceSlot];
+    const auto remember = [&values](int channel, int controller, int value)
+    {
+        values[(size_t) ((channel - 1) * 128 + controller)] = (juce::int8) value;
+    };
+
+    if (message.isController())
+        remember(message.getChannel(), message.getControllerNumber(), message.getControllerValue());
+    else
+        ControllerSysEx::forEachValue(message, ControllerSysEx::stateDump, remember);
+}
+
+//==============================================================================
+MidiDeviceService::Stats MidiDeviceService::getStats() const
+{
+    const auto toMicros = [](juce::int64 ticks) { return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6; };
+
+    Stats stats;
+    stats.numMessages = numMessages.load(std::memory_order_relaxed);
+    stats.numDeviceChanges = numDeviceChanges.load(std::memory_order_relaxed);
+    stats.lastDeviceOpenedMs = lastDeviceOpenedMs.load(std::memory_order_relaxed);
+    stats.callbackMicrosTotal = toMicros(callbackTicksTotal.load(std::memory_order_relaxed));
+    stats.callbackMicrosMax = toMicros(callbackTicksMax.load(std::memory_order_relaxed));
+    return stats;
+}
+
+void MidiDeviceService::resetStats()
+{
+    numMessages = 0;
+    callbackTicksTotal = 0;
+    callbackTicksMax = 0;
+    numDeviceChanges = 0;
+}
+
+//==============================================================================
+void MidiDeviceService::refreshDevices()
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    const auto available = juce::MidiInput::getAvailableDevices();
+    bool changed = false;
+
+    // Close devices that were unplugged, freeing their slots
+    for (auto& open : openInputs)
+    {
+        if (open == nullptr)
+            continue;
+
+        const auto identifier = open->input->getIdentifier();
+        const bool stillThere = std::any_of(available.begin(), available.end(),
+                                            [&](const auto& device) { return device.identifier == identifier; });
+
+        if (stillThere)
+            continue;
+
+        DBG("MIDI input closed: " + open->input->getName());
+        open->input->stop();
+        heartbeats[(size_t) open->slot].setOpen(false);
+        open.reset();
+        changed = true;
+    }
+
+    // Open the ones that are new in the lowest free slots, but don't start
+    // them until subscribers have updated their routing
+    juce::Array<OpenInput*> opened;
+
+    for (const auto& device : available)
+    {
+        const bool alreadyOpen = std::any_of(openInputs.begin(), openInputs.end(),
+                                             [&](const auto& open) { return open != nullptr && open->input->getIdentifier() == device.identifier; });
+
+        if (alreadyOpen)
+            continue;
+
+        const auto freeSlot = std::find(openInputs.begin(), openInputs.end(), nullptr);
+
+        if (freeSlot == openInputs.end())
+        {
+            DBG("MIDI input not opened, all slots in use: " + device.name);
+            continue;
+        }
+
+        auto open = std::make_unique<OpenInput>(*this, (int) std::distance(openInputs.begin(), freeSlot));
+        open->input = juce::MidiInput::openDevice(device.identifier, open.get());
+
+        if (open->input != nullptr)
+        {
+            DBG("MIDI input opened: " + device.name);
+
+            heartbeats[(size_t) open->slot].setOpen(true);
+
+            {
+                // A new device in the slot; forget what the last one sent
+                const juce::ScopedLock sl(callbackLock);
+                controllerValues[(size_t) open->slot].fill(-1);
+            }
+
+            opened.add(open.get());
+            *freeSlot = std::move(open);
+            changed = true;
+        }
+    }
+
+    numOpenDevices.store((int) std::count_if(openInputs.begin(), openInputs.end(),
+                                             [](const auto& open) { return open != nullptr; }),
+                         std::memory_order_relaxed);
+
+    if (changed)
+        sendSynchronousChangeMessage();
+
+    for (auto* open : opened)
+    {
+        open->input->start();
+        lastDeviceOpenedMs.store(juce::Time::getMillisecondCounterHiRes(), std::memory_order_relaxed);
+
+        // Started first, so the reply can't be missed
+        requestState(open->input->getDeviceInfo());
+    }
+}
@@ -0,0 +1,171 @@
+/*
+  ==============================================================================
+
+    MidiDeviceService.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ActiveSensingMonitor.h"
+#include "SharedControlChannel.h"
+
+// One per process: opens every MIDI input once and fans its messages out
+// to all subscribed plugin instances. Hold it through
+// juce::SharedResourcePointer<MidiDeviceService>; it's created with the
+// first instance and torn down with the last.
+//
+// Hotplug comes from juce::MidiDeviceListConnection, so nothing polls the
+// device list; opening and closing happens on the message thread.
+//
+// Each open device sits in a numbered slot for as long as it stays open, and
+// its messages are delivered with that slot, so subscribers can route them
+// through a table indexed by slot. A change message goes out (synchronously,
+// before any new device starts) whenever the slots change.
+//
+// Each slot has an ActiveSensingMonitor, so a hung or unplugged controller
+// that sends Active Sensing shows up within a few hundred milliseconds.
+// Active Sensing is consumed here and not passed on.
+//
+// A newly opened gain knob (see ControllerSysEx.h) is asked for a full state
+// dump through the output port of the same name, so its current values
+// arrive in one reply. The service remembers the last value of every
+// controller on each device and hands them to callbacks as a whole (see
+// sendDeviceStates), so a new or reloaded instance starts from them instead
+// of the device being asked again.
+//
+// While a control daemon is running (see SharedControlChannel.h), the
+// daemon owns the devices: the service closes them when its heartbeat
+// appears and opens them again when it stops, so the hardware changes hands
+// without reloading any instance.
+class MidiDeviceService : public juce::ChangeBroadcaster,
+                          private juce::ChangeListener
+{
+public:
+    //==============================================================================
+    static constexpr int kMaxDevices = 8;
+
+    // Last value of every controller on a device, at (channel - 1) * 128 +
+    // controller; -1 where nothing was heard yet
+    static constexpr int kNumControllerSlots = 16 * 128;
+    using ControllerValues = std::array<juce::int8, kNumControllerSlots>;
+
+    class Callback
+    {
+    public:
+        virtual ~Callback() = default;
+
+        // MIDI input thread
+        virtual void handleDeviceMidi(int deviceSlot, const juce::MidiMessage& message) = 0;
+
+        // From sendDeviceStates(), on its thread: where an open device's
+        // controllers are. By default each known value is passed to
+        // handleDeviceMidi() as a CC.
+        virtual void handleDeviceState(int deviceSlot, const ControllerValues& values);
+    };
+
+    MidiDeviceService();
+    ~MidiDeviceService() override;
+
+    // Message thread. A new callback is sent the device states first.
+    void addCallback(Callback* callback);
+    void removeCallback(Callback* callback);
+
+    // Any thread: calls the callback's handleDeviceState() for every open
+    // device. Holds the delivery lock, so no newer message overtakes it.
+    void sendDeviceStates(Callback* callback);
+
+    // Message thread. Empty if nothing is open in the slot.
+    juce::MidiDeviceInfo getDeviceInfo(int deviceSlot) const;
+
+    // Any thread
+    int getNumOpenDevices() const { return numOpenDevices.load(std::memory_order_relaxed); }
+
+    // Any thread. Open devices that are alive: those that have sent Active
+    // Sensing within the timeout, and those that never send it at all.
+    int getNumConnectedDevices() const;
+
+    static constexpr int kDefaultActiveSensingTimeoutMs = ActiveSensingMonitor::kDefaultTimeoutMs;
+    void setActiveSensingTimeout(int milliseconds) { sensingTimeoutMs.store((juce::uint32) juce::jmax(1, milliseconds), std::memory_order_relaxed); }
+    int getActiveSensingTimeout() const { return (int) sensingTimeoutMs.load(std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Counters for checking hotplug and delivery without hardware: drive the
+    // service from a virtual port (e.g. juce::MidiOutput::createNewDevice on
+    // ALSA/CoreMIDI) and compare against what was sent. Any thread.
+    struct Stats
+    {
+        juce::int64 numMessages = 0;
+        int numDeviceChanges = 0;           // device list notifications handled
+        double lastDeviceOpenedMs = 0.0;    // getMillisecondCounterHiRes() of the last open
+        double callbackMicrosTotal = 0.0;   // time spent fanning messages out
+        double callbackMicrosMax = 0.0;
+    };
+
+    Stats getStats() const;
+    void resetStats();
+
+private:
+    //==============================================================================
+    // Receives one device's messages, so the slot comes with the callback
+    // instead of being looked up per message
+    struct OpenInput : public juce::MidiInputCallback
+    {
+        OpenInput(MidiDeviceService& s, int slotIndex) : service(s), slot(slotIndex) {}
+
+        void handleIncomingMidiMessage(juce::MidiInput*, const juce::MidiMessage& message) override
+        {
+            service.deliver(slot, message);
+        }
+
+        MidiDeviceService& service;
+        const int slot;
+        std::unique_ptr<juce::MidiInput> input;
+    };
+
+    void deliver(int deviceSlot, const juce::MidiMessage& message);
+
+    // Takes the hardware over from a daemon that went away, or hands it to
+    // one that appeared
+    void changeListenerCallback(juce::ChangeBroadcaster*) override;
+    void openDevices();
+    void closeDevices();
+
+    // Opens new devices and closes the ones that went away
+    void refreshDevices();
+
+    // Sends a state request to the output that belongs to the input, if
+    // it's a gain knob
+    static void requestState(const juce::MidiDeviceInfo& input);
+
+    std::array<std::unique_ptr<OpenInput>, kMaxDevices> openInputs;
+
+    std::array<ActiveSensingMonitor, kMaxDevices> heartbeats;
+    std::atomic<juce::uint32> sensingTimeoutMs { (juce::uint32) kDefaultActiveSensingTimeoutMs };
+    std::atomic<int> numOpenDevices { 0 };
+
+    // Remembers the controller values in a CC or state dump. Under callbackLock.
+    void rememberValues(int deviceSlot, const juce::MidiMessage& message);
+
+    juce::CriticalSection callbackLock;
+    juce::Array<Callback*> callbacks;
+
+    // Only touched under callbackLock
+    std::array<ControllerValues, kMaxDevices> controllerValues;
+
+    // Written by the MIDI thread (messages) and the message thread (devices)
+    std::atomic<juce::int64> numMessages { 0 };
+    std::atomic<juce::int64> callbackTicksTotal { 0 };
+    std::atomic<juce::int64> callbackTicksMax { 0 };
+    std::atomic<int> numDeviceChanges { 0 };
+    std::atomic<double> lastDeviceOpenedMs { 0.0 };
+
+    juce::MidiDeviceListConnection deviceListConnection;
+
+    // Only watched for the heartbeat; instances read the values themselves
+    SharedControlReader daemon;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiDeviceService)
+};
@@ -12,123 +12,196 @@
 #include "MidiGainController.h"
 
 //==============================================================================
-MidiGainController::MidiGainController(juce::AudioProcessorValueTreeState& apvts)
-    : parameters(apvts)
+MidiGainController::MidiGainController(juce::AudioProcessorValueTreeState& apvts, MidiDeviceService* devices)
+    : deviceService(devices), parameters(apvts)
 {
-    // Initialize the device manager with no audio inputs/outputs, but enable MIDI input
-    deviceManager.initialise(0, 2, nullptr, true);
+    gainParameterIndex = parameters.getParameter("gain")->getParameterIndex();
     
-    // Start checking for controller connections every 2 seconds
-    startTimer(2000);
-    
-    // Initial search for MIDI devices
-    refreshMidiInputs();
+    // Default mapping: CC #7 on every channel drives the gain, in every table
+    // so a device moved to its own table keeps working
+    MidiLearnTable::Mapping gainMapping;
+    gainMapping.parameterIndex = gainParameterIndex;
+    for (auto& table : learnTables)
+        for (int channel = 1; channel <= MidiLearnTable::kNumChannels; ++channel)
+            table.setMapping(channel, kMidiCC, gainMapping);
     
+    if (deviceService != nullptr)
+        deviceService->addChangeListener(this);
 }
 
 MidiGainController::~MidiGainController()
 {
-    stopTimer();
-    
-    // Clean up any MIDI callbacks
-    if (!lastConnectedDeviceID.isEmpty())
-        deviceManager.removeMidiInputCallback(lastConnectedDeviceID, this);
+    if (deviceService != nullptr)
+        deviceService->removeChangeListener(this);
 }
 
 //==============================================================================
 bool MidiGainController::isDeviceConnected() const
 {
-    return deviceConnected;
+    // Driven by Active Sensing where the device sends it, so no enumeration
+    return deviceService != nullptr && deviceService->getNumConnectedDevices() > 0;
 }
 
-void MidiGainController::processMidiBuffer(const juce::MidiBuffer& midiMessages)
+void MidiGainController::prepareToPlay()
 {
-    // Process any incoming MIDI messages from the plugin's audio processor
-    for (const auto metadata : midiMessages)
-    {
-        handleIncomingMidiMessage(nullptr, metadata.getMessage());
-    }
+    // Not running concurrently with processBlock, so any half-received
+    // sequence can be dropped here
+    controllerParser.reset();
+    
+    for (auto& decoder : deviceDecoders)
+        decoder.reset();
 }
 
-void MidiGainController::prepareToPlay()
+//==============================================================================
+bool MidiGainController::mapMessage(const juce::MidiMessage& message, int& parameterIndex, float& normalisedValue)
+{
+    HighResControllerParser::Event event;
+    
+    if (! controllerParser.process(message, event))  // CC, 14-bit CC or a complete NRPN/RPN value
+        return false;
+    
+    return dispatch(learnTables[0], event.type, event.channel, event.number, event.getNormalised(), parameterIndex, normalisedValue);
+}
+
+bool MidiGainController::mapDeviceMessage(int deviceSlot, const juce::MidiMessage& message, int& parameterIndex, float& normalisedValue)
+{
+    if (! juce::isPositiveAndBelow(deviceSlot, MidiDeviceService::kMaxDevices))
+        return mapMessage(message, parameterIndex, normalisedValue);
+    
+    // Only channel voice messages carry controllers
+    juce::uint32 word = 0;
+    return UmpControllerDecoder::fromBytestream(message, word)
+        && mapDevicePacket(deviceSlot, &word, parameterIndex, normalisedValue);
+}
+
+bool MidiGainController::mapDevicePacket(int deviceSlot, const juce::uint32* words, int& parameterIndex, float& normalisedValue)
+{
+    if (! juce::isPositiveAndBelow(deviceSlot, MidiDeviceService::kMaxDevices))
+        return false;
+    
+    UmpControllerDecoder::Event event;
+    
+    if (! deviceDecoders[(size_t) deviceSlot].process(words, event))
+        return false;
+    
+    auto& table = learnTables[(size_t) deviceRoutes[(size_t) deviceSlot].load(std::memory_order_relaxed)];
+    return dispatch(table, event.type, event.channel, event.number, event.getNormalised(), parameterIndex, normalisedValue);
+}
+
+bool MidiGainController::dispatch(MidiLearnTable& table, HighResControllerParser::Type type, int channel, int number, float input,
+                                  int& parameterIndex, float& normalisedValue)
 {
-    // Ensure MIDI is initialized properly
-    refreshMidiInputs();
+    // One table lookup for any channel/controller; unmapped ones are ignored
+    if (type == HighResControllerParser::Type::controller)
+        return table.dispatch(channel, number, input, parameterIndex, normalisedValue);
+    
+    return table.dispatchParameter(channel, number, type == HighResControllerParser::Type::rpn,
+                                        input, parameterIndex, normalisedValue);
+}
+
+bool MidiGainController::isStateController(int controller)
+{
+    // 6 is data entry, 96-101 data increment/decrement and the NRPN/RPN numbers
+    return controller != 6 && (controller < 32 || controller >= 64) && (controller < 96 || controller > 101);
 }
 
 //==============================================================================
-void MidiGainController::handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message)
+void MidiGainController::setDeviceTable(const juce::String& match, int table)
 {
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    deviceAssignments.removeIf([&](const DeviceAssignment& assignment) { return assignment.match == match; });
     
-    if (message.isController())  // Check if the message is a MIDI CC message
+    if (juce::isPositiveAndBelow(table - 1, kMaxDeviceTables) && match.isNotEmpty())
+        deviceAssignments.add({ match, table });
+    
+    updateDeviceRoutes();
+}
+
+int MidiGainController::getDeviceTable(const juce::String& match) const
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+    
+    for (const auto& assignment : deviceAssignments)
+        if (assignment.match == match)
+            return assignment.table;
+    
+    return 0;
+}
+
+void MidiGainController::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    // The device service changed its slots
+    juce::ignoreUnused(source);
+    updateDeviceRoutes();
+}
+
+void MidiGainController::updateDeviceRoutes()
+{
+    if (deviceService == nullptr)
+        return;
+    
+    // Names are compared here, on hotplug, so dispatch is a single indexed load
+    for (int slot = 0; slot < MidiDeviceService::kMaxDevices; ++slot)
     {
-        if (message.getControllerNumber() == kMidiCC)  // Assuming CC#7 (Volume) controls the gain
+        const auto info = deviceService->getDeviceInfo(slot);
+        int table = 0;
+        
+        for (const auto& assignment : deviceAssignments)
         {
-            float midiValue = message.getControllerValue() / 127.0f; // Normalize 0-127 to 0.0-1.0
-            
-            // Update the "gain" parameter in the AudioProcessorValueTreeState
-            parameters.getParameter("gain")->setValueNotifyingHost(midiValue);
-            deviceConnected = true;
+            if (info.identifier.isNotEmpty()
+                && (assignment.match == info.identifier || assignment.match == info.name))
+            {
+                table = assignment.table;
+                break;
+            }
         }
         
+        deviceRoutes[(size_t) slot].store(table, std::memory_order_relaxed);
     }
 }
-//==============================================================================
-void MidiGainController::timerCallback()
-{
-    // Periodically check if our device is still connected
-    refreshMidiInputs();
-}
 
-void MidiGainController::refreshMidiInputs()
+juce::ValueTree MidiGainController::devicesToValueTree(const juce::AudioProcessor& processor) const
 {
-    // Get list of all available MIDI input devices
-    auto midiInputs = juce::MidiInput::getAvailableDevices();
+    juce::ValueTree tree("MIDI_DEVICES");
     
-    // Track if we find the device
-    bool foundDevice = false;
+    for (const auto& assignment : deviceAssignments)
+        tree.appendChild(juce::ValueTree("DEVICE", { { "match", assignment.match }, { "table", assignment.table } }), nullptr);
     
-    // Look for any MIDI device - in a real app, you might want to look for specific device names
-    for (auto& device : midiInputs)
+    // Only the tables something is routed to are worth storing
+    for (int table = 1; table <= kMaxDeviceTables; ++table)
     {
-        // You could filter for specific devices by name, for example:
-        // if (device.name.containsIgnoreCase("Arduino") || device.name.containsIgnoreCase("Micro"))
+        if (! std::any_of(deviceAssignments.begin(), deviceAssignments.end(),
+                          [table](const DeviceAssignment& assignment) { return assignment.table == table; }))
+            continue;
         
-        // Enable the first available device
-        if (!deviceManager.isMidiInputDeviceEnabled(device.identifier))
+        juce::ValueTree tableTree("TABLE", { { "number", table } });
+        tableTree.appendChild(learnTables[(size_t) table].toValueTree(processor), nullptr);
+        tree.appendChild(tableTree, nullptr);
+    }
+    
+    return tree;
+}
+
+void MidiGainController::devicesFromValueTree(const juce::ValueTree& tree, const juce::AudioProcessor& processor)
+{
+    deviceAssignments.clear();
+    
+    for (const auto& child : tree)
+    {
+        if (child.hasType("DEVICE"))
         {
-            // If we already had a different device, remove its callback
-            if (!lastConnectedDeviceID.isEmpty() && lastConnectedDeviceID != device.identifier)
-                deviceManager.removeMidiInputCallback(lastConnectedDeviceID, this);
-            
-            // Enable the new device and register for callbacks
-            deviceManager.setMidiInputDeviceEnabled(device.identifier, true);
-            deviceManager.addMidiInputCallback(device.identifier, this);
-            
-            // Remember this device
-            lastConnectedDeviceID = device.identifier;
-            foundDevice = true;
-            deviceConnected = true;
-            
-            DBG("MIDI controller connected: " + device.name);
-            break;
+            const int table = child.getProperty("table", 0);
+            if (juce::isPositiveAndBelow(table - 1, kMaxDeviceTables))
+                deviceAssignments.add({ child.getProperty("match").toString(), table });
         }
-        else if (device.identifier == lastConnectedDeviceID)
+        else if (child.hasType("TABLE"))
         {
-            // Our device is still connected
-            foundDevice = true;
-            break;
+            const int table = child.getProperty("number", 0);
+            if (juce::isPositiveAndBelow(table - 1, kMaxDeviceTables))
+                learnTables[(size_t) table].fromValueTree(child.getChildWithName("MIDI_LEARN"), processor);
         }
     }
     
-    // Update connection status
-    deviceConnected = foundDevice;
-    
-    // If no device found and we had one before, update state
-    if (!foundDevice && !lastConnectedDeviceID.isEmpty())
-    {
-        DBG("MIDI controller disconnected");
-        deviceManager.removeMidiInputCallback(lastConnectedDeviceID, this);
-        lastConnectedDeviceID = "";
-    }
+    updateDeviceRoutes();
 }
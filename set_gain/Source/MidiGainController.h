@@ -11,48 +11,126 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "MidiLearnTable.h"
+#include "HighResControllerParser.h"
+#include "UmpControllerDecoder.h"
+#include "MidiDeviceService.h"
 
-class MidiGainController : public juce::MidiInputCallback,
-                           private juce::Timer
+class MidiGainController : private juce::ChangeListener
 {
 public:
     //==============================================================================
-    // Constructor now takes a reference to AudioProcessorValueTreeState
-    MidiGainController(juce::AudioProcessorValueTreeState& apvts);
+    // Maps MIDI to parameter changes for the processor, which applies them
+    // through its ParameterBridge. devices is the shared service, which must
+    // outlive this, or nullptr for no device input.
+    MidiGainController(juce::AudioProcessorValueTreeState& apvts, MidiDeviceService* devices);
     ~MidiGainController() override;
 
     //==============================================================================
-    // Checks if the MIDI controller is connected
+    // Checks if any MIDI input device is open and alive
     bool isDeviceConnected() const;
     
-    // Call this from your processor's processBlock
-    void processMidiBuffer(const juce::MidiBuffer& midiMessages);
-    
     // Call this in the plugin's prepareToPlay method
     void prepareToPlay();
     
-    //==============================================================================
-    // MidiInputCallback implementation
-    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
+    // CC -> parameter mappings, editable from the message thread. Table 0 is
+    // used by the host and by any device without a table of its own.
+    static constexpr int kMaxDeviceTables = 4;
+    MidiLearnTable& getLearnTable(int table = 0) { return learnTables[(size_t) juce::jlimit(0, kMaxDeviceTables, table)]; }
+    
+    // Message thread. Messages from the device whose name or identifier is
+    // match go through the given table (1 - kMaxDeviceTables, 0 to remove).
+    void setDeviceTable(const juce::String& match, int table);
+    int getDeviceTable(const juce::String& match) const;
+    
+    // Device assignments and their tables, stored as a "MIDI_DEVICES" tree
+    juce::ValueTree devicesToValueTree(const juce::AudioProcessor& processor) const;
+    void devicesFromValueTree(const juce::ValueTree& tree, const juce::AudioProcessor& processor);
+    
+    // Audio thread: parses the message and looks up its mapping without
+    // touching the parameter. Returns false if nothing is mapped to it.
+    bool mapMessage(const juce::MidiMessage& message, int& parameterIndex, float& normalisedValue);
+    
+    // Same for a message from a MidiDeviceService slot, through that device's
+    // table. The routing is a table indexed by slot, updated on hotplug.
+    // Device input is decoded as Universal MIDI Packets: byte-stream
+    // messages are wrapped as MIDI 1.0 packets first.
+    bool mapDeviceMessage(int deviceSlot, const juce::MidiMessage& message, int& parameterIndex, float& normalisedValue);
+    
+    // Same for one packet (getNumWords(words[0]) words) from a device slot,
+    // sharing its decoder state. MIDI 2.0 controllers keep their 32-bit value
+    // all the way to the parameter.
+    bool mapDevicePacket(int deviceSlot, const juce::uint32* words, int& parameterIndex, float& normalisedValue);
+    
+    // Any thread: the parameter values a device's controller state stands
+    // for, through that device's table, as fn(parameterIndex, normalisedValue).
+    // Doesn't touch the parsers, so it can run next to the audio thread.
+    template <typename Function>
+    void forEachDeviceStateValue(int deviceSlot, const MidiDeviceService::ControllerValues& values, Function&& fn) const
+    {
+        if (! juce::isPositiveAndBelow(deviceSlot, MidiDeviceService::kMaxDevices))
+            return;
+        
+        const auto& table = learnTables[(size_t) deviceRoutes[(size_t) deviceSlot].load(std::memory_order_relaxed)];
+        
+        for (int channel = 1; channel <= MidiLearnTable::kNumChannels; ++channel)
+        {
+            const auto* channelValues = values.data() + (channel - 1) * MidiLearnTable::kNumControllers;
+            
+            for (int controller = 0; controller < MidiLearnTable::kNumControllers; ++controller)
+            {
+                const int value = channelValues[controller];
+                int parameterIndex = -1;
+                float normalisedValue = 0.0f;
+                
+                if (value < 0 || ! isStateController(controller))
+                    continue;
+                
+                // An MSB with its LSB known is a 14-bit value, as the parser would read it
+                const int lsb = controller < 32 ? channelValues[controller + 32] : -1;
+                const float input = lsb >= 0 ? (float) ((value << 7) | lsb) / 16383.0f : (float) value / 127.0f;
+                
+                if (table.lookup(channel, controller, input, parameterIndex, normalisedValue))
+                    fn(parameterIndex, normalisedValue);
+            }
+        }
+    }
 
 private:
     //==============================================================================
-    // Timer callback to check for controller connection
-    void timerCallback() override;
+    bool dispatch(MidiLearnTable& table, HighResControllerParser::Type type, int channel, int number, float input,
+                  int& parameterIndex, float& normalisedValue);
     
-    // Refreshes the list of MIDI inputs and finds the controller
-    void refreshMidiInputs();
+    // Controllers that carry a position of their own: not the LSB half of a
+    // 14-bit pair, nor the NRPN/RPN selection and data entry
+    static bool isStateController(int controller);
     
-    //==============================================================================
-    juce::AudioDeviceManager deviceManager;
-    juce::String lastConnectedDeviceID;
+    void changeListenerCallback(juce::ChangeBroadcaster* source) override;
+    void updateDeviceRoutes();
+    
+    // Devices are opened once per process and shared by every instance
+    MidiDeviceService* deviceService = nullptr;
     
     // Reference to the AudioProcessorValueTreeState that contains the gain parameter
     juce::AudioProcessorValueTreeState& parameters;
+    int gainParameterIndex = 0;
     
     // MIDI parameters
-    static constexpr int kMidiCC = 7;  // CC #7 is standard for volume control
-    bool deviceConnected = false;
+    static constexpr int kMidiCC = 7;  // CC #7 is standard for volume control, mapped by default
+    std::array<MidiLearnTable, 1 + kMaxDeviceTables> learnTables;
+    
+    struct DeviceAssignment
+    {
+        juce::String match;
+        int table = 0;
+    };
+    
+    juce::Array<DeviceAssignment> deviceAssignments;                         // message thread
+    std::array<std::atomic<int>, MidiDeviceService::kMaxDevices> deviceRoutes {}; // slot -> table
+    
+    // 14-bit CC / NRPN state, one per stream: the host and every device slot
+    HighResControllerParser controllerParser;
+    std::array<UmpControllerDecoder, MidiDeviceService::kMaxDevices> deviceDecoders;
     
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiGainController)
 };
@@ -0,0 +1,340 @@
+/*
+  ==============================================================================
+
+    MidiLearnTable.cpp
+
+  ==============================================================================
+*/
+
+#include "MidiLearnTable.h"
+#include "FastMath.h"
+
+//==============================================================================
+namespace
+{
+    // Evaluated per message rather than from a 128-point table, so 14-bit
+    // and NRPN inputs get the exact curve instead of a linear interpolation
+    float applyCurve(MidiLearnTable::Curve curve, float input)
+    {
+        const float x = juce::jlimit(0.0f, 1.0f, input);
+
+        // Log: quick rise, log10(1 + 9x). Audio taper: 60 dB of range
+        // spread evenly over the travel, with the bottom pinned to silence.
+        if (curve == MidiLearnTable::Curve::logarithmic)
+            return juce::jmin(1.0f, fastmath::log2(1.0f + 9.0f * x) * (1.0f / 3.321928095f));
+
+        if (curve == MidiLearnTable::Curve::audioTaper)
+            return juce::jlimit(0.0f, 1.0f, (fastmath::dbToGain(60.0f * x) - 1.0f) * (1.0f / 999.0f));
+
+        return x;
+    }
+
+    const juce::StringArray curveNames { "linear", "log", "audio" };
+
+    juce::ValueTree mappingToValueTree(const MidiLearnTable::Mapping& mapping,
+                                       const juce::AudioProcessorParameterWithID& parameter,
+                                       int channel, int number, const juce::String& type)
+    {
+        // Stored by parameter ID so the mapping survives layout changes
+        return juce::ValueTree("MAP", {
+            { "type",       type },
+            { "channel",    channel },
+            { "controller", number },
+            { "parameter",  parameter.paramID },
+            { "min",        mapping.minValue },
+            { "max",        mapping.maxValue },
+            { "curve",      curveNames[(int) mapping.curve] },
+            { "invert",     mapping.invert }
+        });
+    }
+}
+
+//==============================================================================
+MidiLearnTable::MidiLearnTable()
+{
+    clearAll();
+}
+
+void MidiLearnTable::setMapping(int channel, int controller, const Mapping& mapping)
+{
+    if (juce::isPositiveAndBelow(channel - 1, kNumChannels) && juce::isPositiveAndBelow(controller, kNumControllers))
+        table[slotIndex(channel, controller)].store(pack(mapping), std::memory_order_relaxed);
+}
+
+MidiLearnTable::Mapping MidiLearnTable::getMapping(int channel, int controller) const
+{
+    if (juce::isPositiveAndBelow(channel - 1, kNumChannels) && juce::isPositiveAndBelow(controller, kNumControllers))
+        return unpack(table[slotIndex(channel, controller)].load(std::memory_order_relaxed));
+
+    return {};
+}
+
+void MidiLearnTable::clearAll()
+{
+    for (auto& entry : table)
+        entry.store(0, std::memory_order_relaxed);
+
+    for (int i = 0; i < kMaxParameterMappings; ++i)
+    {
+        parameterTable[(size_t) i].store(0, std::memory_order_relaxed);
+        parameterKeys[(size_t) i].store(0, std::memory_order_release);
+    }
+}
+
+bool MidiLearnTable::setParameterMapping(int channel, int number, bool isRpn, const Mapping& mapping)
+{
+    const auto key = parameterKey(channel, number, isRpn);
+    const int slot = key != 0 ? claimParameterSlot(key) : -1;
+
+    if (slot < 0)
+        return false;
+
+    parameterTable[(size_t) slot].store(pack(mapping), std::memory_order_relaxed);
+    return true;
+}
+
+void MidiLearnTable::setCurveFor(int parameterIndex, Curve curve, bool invert)
+{
+    const auto update = [&](std::atomic<juce::uint64>& entry)
+    {
+        auto mapping = unpack(entry.load(std::memory_order_relaxed));
+        if (mapping.parameterIndex == parameterIndex)
+        {
+            mapping.curve = curve;
+            mapping.invert = invert;
+            entry.store(pack(mapping), std::memory_order_relaxed);
+        }
+    };
+
+    for (auto& entry : table)
+        update(entry);
+
+    for (auto& entry : parameterTable)
+        update(entry);
+}
+
+void MidiLearnTable::clearMappingsFor(int parameterIndex)
+{
+    for (auto& entry : table)
+        if (unpack(entry.load(std::memory_order_relaxed)).parameterIndex == parameterIndex)
+            entry.store(0, std::memory_order_relaxed);
+
+    // Entry first, so a reader never sees the freed key with the old mapping
+    for (int i = 0; i < kMaxParameterMappings; ++i)
+    {
+        if (unpack(parameterTable[(size_t) i].load(std::memory_order_relaxed)).parameterIndex == parameterIndex)
+        {
+            parameterTable[(size_t) i].store(0, std::memory_order_relaxed);
+            parameterKeys[(size_t) i].store(0, std::memory_order_release);
+        }
+    }
+}
+
+void MidiLearnTable::startLearning(const Mapping& mapping)
+{
+    learnEntry.store(pack(mapping), std::memory_order_relaxed);
+}
+
+//==============================================================================
+juce::ValueTree MidiLearnTable::toValueTree(const juce::AudioProcessor& processor) const
+{
+    juce::ValueTree tree("MIDI_LEARN");
+    const auto& processorParameters = processor.getParameters();
+
+    for (int channel = 1; channel <= kNumChannels; ++channel)
+    {
+        for (int controller = 0; controller < kNumControllers; ++controller)
+        {
+            const auto mapping = getMapping(channel, controller);
+            auto* parameter = dynamic_cast<juce::AudioProcessorParameterWithID*>(processorParameters[mapping.parameterIndex]);
+
+            if (parameter == nullptr)
+                continue;
+
+            tree.appendChild(mappingToValueTree(mapping, *parameter, channel, controller, "cc"), nullptr);
+        }
+    }
+
+    for (int i = 0; i < kMaxParameterMappings; ++i)
+    {
+        const auto key = parameterKeys[(size_t) i].load(std::memory_order_acquire);
+        const auto mapping = unpack(parameterTable[(size_t) i].load(std::memory_order_relaxed));
+        auto* parameter = dynamic_cast<juce::AudioProcessorParameterWithID*>(processorParameters[mapping.parameterIndex]);
+
+        if (key == 0 || parameter == nullptr)
+            continue;
+
+        tree.appendChild(mappingToValueTree(mapping, *parameter, (int) (key & 0x1f), (int) (key >> 6),
+                                            (key >> 5) & 1 ? "rpn" : "nrpn"), nullptr);
+    }
+
+    return tree;
+}
+
+void MidiLearnTable::fromValueTree(const juce::ValueTree& tree, const juce::AudioProcessor& processor)
+{
+    if (! tree.hasType("MIDI_LEARN"))
+        return;
+
+    clearAll();
+
+    for (const auto& child : tree)
+    {
+        const auto parameterID = child.getProperty("parameter").toString();
+
+        for (auto* p : processor.getParameters())
+        {
+            auto* parameter = dynamic_cast<juce::AudioProcessorParameterWithID*>(p);
+            if (parameter == nullptr || parameter->paramID != parameterID)
+                continue;
+
+            Mapping mapping;
+            mapping.parameterIndex = parameter->getParameterIndex();
+            mapping.minValue = child.getProperty("min", 0.0f);
+            mapping.maxValue = child.getProperty("max", 1.0f);
+            mapping.curve = (Curve) juce::jmax(0, curveNames.indexOf(child.getProperty("curve").toString()));
+            mapping.invert = child.getProperty("invert", false);
+
+            const auto type = child.getProperty("type", "cc").toString();
+            const int channel = child.getProperty("channel", 0);
+            const int number = child.getProperty("controller", -1);
+
+            if (type == "cc")
+                setMapping(channel, number, mapping);
+            else
+                setParameterMapping(channel, number, type == "rpn", mapping);
+            break;
+        }
+    }
+}
+
+//==============================================================================
+bool MidiLearnTable::dispatch(int channel, int controller, float input, int& parameterIndex, float& normalisedValue)
+{
+    if (! juce::isPositiveAndBelow(channel - 1, kNumChannels) || ! juce::isPositiveAndBelow(controller, kNumControllers))
+        return false;
+
+    auto& slot = table[slotIndex(channel, controller)];
+
+    // Plain load first so the common, not-learning case stays a read
+    if (learnEntry.load(std::memory_order_relaxed) != 0)
+        if (auto learnt = learnEntry.exchange(0, std::memory_order_relaxed))
+            slot.store(learnt, std::memory_order_relaxed);
+
+    return resolve(slot.load(std::memory_order_relaxed), input, parameterIndex, normalisedValue);
+}
+
+bool MidiLearnTable::lookup(int channel, int controller, float input, int& parameterIndex, float& normalisedValue) const
+{
+    if (! juce::isPositiveAndBelow(channel - 1, kNumChannels) || ! juce::isPositiveAndBelow(controller, kNumControllers))
+        return false;
+
+    return resolve(table[slotIndex(channel, controller)].load(std::memory_order_relaxed), input, parameterIndex, normalisedValue);
+}
+
+bool MidiLearnTable::dispatchParameter(int channel, int number, bool isRpn, float input, int& parameterIndex, float& normalisedValue)
+{
+    const auto key = parameterKey(channel, number, isRpn);
+    if (key == 0)
+        return false;
+
+    if (learnEntry.load(std::memory_order_relaxed) != 0)
+    {
+        if (auto learnt = learnEntry.exchange(0, std::memory_order_relaxed))
+        {
+            const int claimed = claimParameterSlot(key);
+            if (claimed >= 0)
+                parameterTable[(size_t) claimed].store(learnt, std::memory_order_relaxed);
+        }
+    }
+
+    const int slot = findParameterSlot(key);
+    if (slot < 0)
+        return false;
+
+    return resolve(parameterTable[(size_t) slot].load(std::memory_order_relaxed), input, parameterIndex, normalisedValue);
+}
+
+bool MidiLearnTable::resolve(juce::uint64 entry, float input, int& parameterIndex, float& normalisedValue)
+{
+    if ((entry & 0xff) == 0)
+        return false;
+
+    float shaped = applyCurve((Curve) juce::jmin(2, (int) ((entry >> 8) & 3)), input);
+
+    if ((entry >> 10) & 1)
+        shaped = 1.0f - shaped;
+
+    const float minValue = (float) ((entry >> 16) & 0xffff) / 65535.0f;
+    const float maxValue = (float) ((entry >> 32) & 0xffff) / 65535.0f;
+
+    parameterIndex = (int) (entry & 0xff) - 1;
+    normalisedValue = minValue + (maxValue - minValue) * shaped;
+    return true;
+}
+
+//==============================================================================
+juce::uint32 MidiLearnTable::parameterKey(int channel, int number, bool isRpn)
+{
+    if (! juce::isPositiveAndBelow(channel - 1, kNumChannels) || ! juce::isPositiveAndBelow(number, 16384))
+        return 0;
+
+    return (juce::uint32) channel | (isRpn ? 0x20u : 0u) | ((juce::uint32) number << 6);
+}
+
+int MidiLearnTable::findParameterSlot(juce::uint32 key) const
+{
+    // Short linear scan: a handful of cache lines, no hashing
+    for (int i = 0; i < kMaxParameterMappings; ++i)
+        if (parameterKeys[(size_t) i].load(std::memory_order_acquire) == key)
+            return i;
+
+    return -1;
+}
+
+int MidiLearnTable::claimParameterSlot(juce::uint32 key)
+{
+    const int existing = findParameterSlot(key);
+    if (existing >= 0)
+        return existing;
+
+    // CAS so the message thread and a learn on the audio thread can't take the same slot
+    for (int i = 0; i < kMaxParameterMappings; ++i)
+    {
+        juce::uint32 expected = 0;
+        if (parameterKeys[(size_t) i].compare_exchange_strong(expected, key, std::memory_order_acq_rel))
+            return i;
+    }
+
+    return -1;
+}
+
+//==============================================================================
+juce::uint64 MidiLearnTable::pack(const Mapping& mapping)
+{
+    if (! juce::isPositiveAndBelow(mapping.parameterIndex, 255))
+        return 0;
+
+    const auto toFixed = [](float v) { return (juce::uint64) juce::roundToInt(juce::jlimit(0.0f, 1.0f, v) * 65535.0f); };
+
+    return (juce::uint64) (mapping.parameterIndex + 1)
+         | ((juce::uint64) mapping.curve << 8)
+         | ((juce::uint64) (mapping.invert ? 1 : 0) << 10)
+         | (toFixed(mapping.minValue) << 16)
+         | (toFixed(mapping.maxValue) << 32);
+}
+
+MidiLearnTable::Mapping MidiLearnTable::unpack(juce::uint64 entry)
+{
+    Mapping mapping;
+
+    if ((entry & 0xff) == 0)
+        return mapping;
+
+    mapping.parameterIndex = (int) (entry & 0xff) - 1;
+    mapping.curve = (Curve) juce::jmin(2, (int) ((entry >> 8) & 3));
+    mapping.invert = ((entry >> 10) & 1) != 0;
+    mapping.minValue = (float) ((entry >> 16) & 0xffff) / 65535.0f;
+    mapping.maxValue = (float) ((entry >> 32) & 0xffff) / 65535.0f;
+    return mapping;
+}
@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    MidiLearnTable.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Maps every (channel, controller) pair to a parameter. The table is a flat
+// 16x128 array with one packed 64-bit entry per slot, so dispatching a CC
+// is a single atomic load and the table can be edited from the message
+// thread (or learnt on the audio thread) without locking.
+//
+// NRPN/RPN numbers are too sparse for a flat table, so a small fixed list
+// of keyed slots holds those mappings instead.
+class MidiLearnTable
+{
+public:
+    //==============================================================================
+    static constexpr int kNumChannels = 16;
+    static constexpr int kNumControllers = 128;
+    static constexpr int kMaxParameterMappings = 32;
+
+    enum class Curve { linear, logarithmic, audioTaper };
+
+    struct Mapping
+    {
+        int parameterIndex = -1;    // -1 = unmapped
+        float minValue = 0.0f;      // normalised parameter range
+        float maxValue = 1.0f;
+        Curve curve = Curve::linear;
+        bool invert = false;
+    };
+
+    //==============================================================================
+    MidiLearnTable();
+
+    // Message thread. Channels are 1-16 like juce::MidiMessage.
+    void setMapping(int channel, int controller, const Mapping& mapping);
+    Mapping getMapping(int channel, int controller) const;
+    void clearAll();
+    
+    // Same for a 14-bit NRPN or RPN number. Returns false if the list is full.
+    bool setParameterMapping(int channel, int number, bool isRpn, const Mapping& mapping);
+
+    // Apply to every slot mapped to the parameter
+    void setCurveFor(int parameterIndex, Curve curve, bool invert);
+    void clearMappingsFor(int parameterIndex);
+
+    // The next CC or NRPN/RPN that arrives on any channel is mapped to the parameter
+    void startLearning(const Mapping& mapping);
+    void stopLearning() { learnEntry.store(0, std::memory_order_relaxed); }
+    bool isLearning() const { return learnEntry.load(std::memory_order_relaxed) != 0; }
+
+    juce::ValueTree toValueTree(const juce::AudioProcessor& processor) const;
+    void fromValueTree(const juce::ValueTree& tree, const juce::AudioProcessor& processor);
+
+    //==============================================================================
+    // Any thread. input is the controller position 0-1. Returns false if the
+    // slot is unmapped, otherwise the target parameter and its normalised value.
+    bool dispatch(int channel, int controller, float input, int& parameterIndex, float& normalisedValue);
+    bool dispatchParameter(int channel, int number, bool isRpn, float input, int& parameterIndex, float& normalisedValue);
+
+    // Same as dispatch() for a value nobody just moved, such as a device's
+    // stored state: never takes a pending learn
+    bool lookup(int channel, int controller, float input, int& parameterIndex, float& normalisedValue) const;
+
+private:
+    //==============================================================================
+    // Entry layout: bits 0-7 parameter index + 1 (0 = unmapped), 8-9 curve,
+    // 10 invert, 16-31 min, 32-47 max (both 0-65535 over 0-1)
+    static juce::uint64 pack(const Mapping& mapping);
+    static Mapping unpack(juce::uint64 entry);
+    static size_t slotIndex(int channel, int controller) { return (size_t) ((channel - 1) * kNumControllers + controller); }
+    static bool resolve(juce::uint64 entry, float input, int& parameterIndex, float& normalisedValue);
+    
+    // NRPN/RPN keys: bits 0-4 channel, 5 RPN flag, 6-19 number. 0 = free.
+    static juce::uint32 parameterKey(int channel, int number, bool isRpn);
+    int findParameterSlot(juce::uint32 key) const;
+    int claimParameterSlot(juce::uint32 key);
+
+    std::array<std::atomic<juce::uint64>, kNumChannels * kNumControllers> table;
+    std::array<std::atomic<juce::uint32>, kMaxParameterMappings> parameterKeys;
+    std::array<std::atomic<juce::uint64>, kMaxParameterMappings> parameterTable;
+    std::atomic<juce::uint64> learnEntry { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(MidiLearnTable)
+};
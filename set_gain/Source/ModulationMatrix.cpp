@@ -0,0 +1,345 @@
+/*
+  ==============================================================================
+
+    ModulationMatrix.cpp
+
+  ==============================================================================
+*/
+
+#include "ModulationMatrix.h"
+
+//==============================================================================
+ModulationMatrix::ModulationMatrix()
+{
+    for (auto& v : ccValues)
+        v.store(0.0f, std::memory_order_relaxed);
+
+    writeSharedRoutes(editRoutes);
+    audioRateRow.fill(-1);
+
+    // Second follower listens to the channels after the main stereo pair
+    followers[1].firstChannel.store(2, std::memory_order_relaxed);
+}
+
+void ModulationMatrix::setAudioRate(int destination, bool shouldBeAudioRate)
+{
+    jassert(juce::isPositiveAndBelow(destination, kMaxDestinations));
+    audioRate[(size_t) destination] = shouldBeAudioRate;
+}
+
+void ModulationMatrix::prepareToPlay(double newSampleRate, int samplesPerBlock)
+{
+    sampleRate = newSampleRate;
+
+    // One-pole coefficients at control rate: 5 ms attack, 150 ms release
+    const double controlRate = sampleRate / kControlInterval;
+    followerAttack  = (float) std::exp(-1.0 / (0.005 * controlRate));
+    followerRelease = (float) std::exp(-1.0 / (0.150 * controlRate));
+
+    audioRateDestinations.clear();
+    audioRateRow.fill(-1);
+
+    for (int d = 0; d < kMaxDestinations; ++d)
+    {
+        if (audioRate[(size_t) d])
+        {
+            audioRateRow[(size_t) d] = (int) audioRateDestinations.size();
+            audioRateDestinations.push_back(d);
+        }
+    }
+
+    audioRateBuffer.setSize(juce::jmax(1, (int) audioRateDestinations.size()), samplesPerBlock);
+    audioRateBuffer.clear();
+
+    targetValues.fill(0.0f);
+    currentValues.fill(0.0f);
+
+    for (auto& f : followers)
+        f.level = 0.0f;
+}
+
+//==============================================================================
+bool ModulationMatrix::addRoute(int source, int destination, float depth)
+{
+    if (! juce::isPositiveAndBelow(source, kNumSources)
+        || ! juce::isPositiveAndBelow(destination, kMaxDestinations)
+        || editRoutes.numRoutes >= kMaxRoutes)
+        return false;
+
+    auto index = (size_t) editRoutes.numRoutes++;
+    editRoutes.source[index] = source;
+    editRoutes.destination[index] = destination;
+    editRoutes.depth[index] = depth;
+
+    writeSharedRoutes(editRoutes);
+    return true;
+}
+
+void ModulationMatrix::clearRoutes()
+{
+    editRoutes.numRoutes = 0;
+    writeSharedRoutes(editRoutes);
+}
+
+int ModulationMatrix::getNumRoutes() const
+{
+    return editRoutes.numRoutes;
+}
+
+void ModulationMatrix::setLfo(int lfoIndex, LfoShape shape, double beatsPerCycle)
+{
+    if (! juce::isPositiveAndBelow(lfoIndex, kNumLfos) || beatsPerCycle <= 0.0)
+        return;
+
+    lfos[(size_t) lfoIndex].shape.store((int) shape, std::memory_order_relaxed);
+    lfos[(size_t) lfoIndex].beatsPerCycle.store(beatsPerCycle, std::memory_order_relaxed);
+}
+
+ModulationMatrix::LfoShape ModulationMatrix::getLfoShape(int lfoIndex) const
+{
+    return (LfoShape) lfos[(size_t) lfoIndex].shape.load(std::memory_order_relaxed);
+}
+
+double ModulationMatrix::getLfoBeatsPerCycle(int lfoIndex) const
+{
+    return lfos[(size_t) lfoIndex].beatsPerCycle.load(std::memory_order_relaxed);
+}
+
+void ModulationMatrix::setEnvelopeFollowerInput(int followerIndex, int firstChannel, int numChannels)
+{
+    if (! juce::isPositiveAndBelow(followerIndex, kNumEnvelopeFollowers))
+        return;
+
+    followers[(size_t) followerIndex].firstChannel.store(firstChannel, std::memory_order_relaxed);
+    followers[(size_t) followerIndex].numChannels.store(numChannels, std::memory_order_relaxed);
+}
+
+juce::ValueTree ModulationMatrix::toValueTree() const
+{
+    juce::ValueTree tree("MODULATION");
+
+    for (int i = 0; i < editRoutes.numRoutes; ++i)
+    {
+        tree.appendChild(juce::ValueTree("ROUTE", {
+            { "source",      editRoutes.source[(size_t) i] },
+            { "destination", editRoutes.destination[(size_t) i] },
+            { "depth",       editRoutes.depth[(size_t) i] }
+        }), nullptr);
+    }
+
+    for (int i = 0; i < kNumLfos; ++i)
+    {
+        tree.appendChild(juce::ValueTree("LFO", {
+            { "index",         i },
+            { "shape",         lfos[(size_t) i].shape.load(std::memory_order_relaxed) },
+            { "beatsPerCycle", lfos[(size_t) i].beatsPerCycle.load(std::memory_order_relaxed) }
+        }), nullptr);
+    }
+
+    return tree;
+}
+
+void ModulationMatrix::fromValueTree(const juce::ValueTree& tree)
+{
+    if (! tree.hasType("MODULATION"))
+        return;
+
+    editRoutes.numRoutes = 0;
+
+    for (const auto& child : tree)
+    {
+        if (child.hasType("ROUTE"))
+        {
+            const int source = child.getProperty("source", -1);
+            const int destination = child.getProperty("destination", -1);
+
+            if (juce::isPositiveAndBelow(source, kNumSources)
+                && juce::isPositiveAndBelow(destination, kMaxDestinations)
+                && editRoutes.numRoutes < kMaxRoutes)
+            {
+                auto index = (size_t) editRoutes.numRoutes++;
+                editRoutes.source[index] = source;
+                editRoutes.destination[index] = destination;
+                editRoutes.depth[index] = (float) child.getProperty("depth", 0.0f);
+            }
+        }
+        else if (child.hasType("LFO"))
+        {
+            setLfo(child.getProperty("index", -1),
+                   (LfoShape) juce::jlimit(0, 3, (int) child.getProperty("shape", 0)),
+                   child.getProperty("beatsPerCycle", 1.0));
+        }
+    }
+
+    writeSharedRoutes(editRoutes);
+}
+
+//==============================================================================
+void ModulationMatrix::handleMidiMessage(const juce::MidiMessage& message)
+{
+    if (message.isController())
+        ccValues[(size_t) message.getControllerNumber()].store(message.getControllerValue() / 127.0f,
+                                                               std::memory_order_relaxed);
+}
+
+void ModulationMatrix::process(const juce::AudioBuffer<float>& input,
+                               const juce::Optional<juce::AudioPlayHead::PositionInfo>& position)
+{
+    pullSharedRoutes();
+
+    // CCs only change between blocks, so read them once here
+    for (int i = 0; i < kNumCcSources; ++i)
+        sourceValues[(size_t) i] = ccValues[(size_t) i].load(std::memory_order_relaxed);
+
+    // Lock the LFOs to the host's beat position while it is playing,
+    // otherwise let them free-run at the last known tempo
+    if (position.hasValue())
+    {
+        if (auto bpm = position->getBpm())
+            lastBpm = *bpm;
+
+        if (position->getIsPlaying())
+        {
+            if (auto ppq = position->getPpqPosition())
+            {
+                for (auto& lfo : lfos)
+                {
+                    const double cycles = *ppq / lfo.beatsPerCycle.load(std::memory_order_relaxed);
+                    lfo.phase = cycles - std::floor(cycles);
+                }
+            }
+        }
+    }
+
+    // The audio-rate buffer is sized in prepareToPlay; larger host blocks
+    // have to be split by the caller
+    jassert(input.getNumSamples() <= audioRateBuffer.getNumSamples());
+    const int numSamples = juce::jmin(input.getNumSamples(), audioRateBuffer.getNumSamples());
+
+    for (int start = 0; start < numSamples; start += kControlInterval)
+    {
+        const int length = juce::jmin(kControlInterval, numSamples - start);
+        evaluateSources(input, start, length);
+
+        targetValues.fill(0.0f);
+
+        for (int r = 0; r < routes.numRoutes; ++r)
+            targetValues[(size_t) routes.destination[(size_t) r]]
+                += sourceValues[(size_t) routes.source[(size_t) r]] * routes.depth[(size_t) r];
+
+        // Linear ramp from the previous control value, audio-rate destinations only
+        for (size_t row = 0; row < audioRateDestinations.size(); ++row)
+        {
+            const auto d = (size_t) audioRateDestinations[row];
+            const float from = currentValues[d];
+            const float step = (targetValues[d] - from) / (float) length;
+            auto* out = audioRateBuffer.getWritePointer((int) row, start);
+
+            for (int i = 0; i < length; ++i)
+                out[i] = from + step * (float) (i + 1);
+        }
+
+        currentValues = targetValues;
+    }
+}
+
+const float* ModulationMatrix::getAudioRateModulation(int destination) const
+{
+    if (! juce::isPositiveAndBelow(destination, kMaxDestinations) || ! routed[(size_t) destination])
+        return nullptr;
+
+    const int row = audioRateRow[(size_t) destination];
+    return row >= 0 ? audioRateBuffer.getReadPointer(row) : nullptr;
+}
+
+//==============================================================================
+void ModulationMatrix::evaluateSources(const juce::AudioBuffer<float>& input, int startSample, int numSamples)
+{
+    const double cyclesPerSample = lastBpm / (60.0 * sampleRate);
+
+    for (int i = 0; i < kNumLfos; ++i)
+    {
+        auto& lfo = lfos[(size_t) i];
+        sourceValues[(size_t) (kFirstLfoSource + i)] = lfoValue((LfoShape) lfo.shape.load(std::memory_order_relaxed), lfo.phase);
+
+        lfo.phase += numSamples * cyclesPerSample / lfo.beatsPerCycle.load(std::memory_order_relaxed);
+        lfo.phase -= std::floor(lfo.phase);
+    }
+
+    for (int i = 0; i < kNumEnvelopeFollowers; ++i)
+    {
+        auto& follower = followers[(size_t) i];
+        const int first = follower.firstChannel.load(std::memory_order_relaxed);
+        const int last = juce::jmin(input.getNumChannels(), first + follower.numChannels.load(std::memory_order_relaxed));
+
+        float peak = 0.0f;
+        for (int ch = juce::jmax(0, first); ch < last; ++ch)
+            peak = juce::jmax(peak, input.getMagnitude(ch, startSample, numSamples));
+
+        const float coeff = peak > follower.level ? followerAttack : followerRelease;
+        follower.level = peak + coeff * (follower.level - peak);
+        sourceValues[(size_t) (kFirstEnvelopeFollowerSource + i)] = follower.level;
+    }
+}
+
+float ModulationMatrix::lfoValue(LfoShape shape, double phase)
+{
+    switch (shape)
+    {
+        case LfoShape::triangle: return (float) (1.0 - 4.0 * std::abs(phase - 0.5));
+        case LfoShape::saw:      return (float) (2.0 * phase - 1.0);
+        case LfoShape::square:   return phase < 0.5 ? 1.0f : -1.0f;
+        case LfoShape::sine:
+        default:                 return (float) std::sin(juce::MathConstants<double>::twoPi * phase);
+    }
+}
+
+//==============================================================================
+void ModulationMatrix::writeSharedRoutes(const Routes& source)
+{
+    // Single writer (message thread). An odd sequence number means a write
+    // is in progress; the audio thread skips the update until it is even.
+    const auto sequence = sharedRoutes.sequence.load(std::memory_order_relaxed);
+    sharedRoutes.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (size_t i = 0; i < (size_t) kMaxRoutes; ++i)
+    {
+        sharedRoutes.source[i].store(source.source[i], std::memory_order_relaxed);
+        sharedRoutes.destination[i].store(source.destination[i], std::memory_order_relaxed);
+        sharedRoutes.depth[i].store(source.depth[i], std::memory_order_relaxed);
+    }
+
+    sharedRoutes.numRoutes.store(source.numRoutes, std::memory_order_relaxed);
+    sharedRoutes.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void ModulationMatrix::pullSharedRoutes()
+{
+    const auto sequence = sharedRoutes.sequence.load(std::memory_order_acquire);
+
+    if (sequence == lastSequence || (sequence & 1) != 0)
+        return;
+
+    Routes copy;
+    copy.numRoutes = juce::jlimit(0, kMaxRoutes, sharedRoutes.numRoutes.load(std::memory_order_relaxed));
+
+    for (size_t i = 0; i < (size_t) copy.numRoutes; ++i)
+    {
+        copy.source[i] = sharedRoutes.source[i].load(std::memory_order_relaxed);
+        copy.destination[i] = sharedRoutes.destination[i].load(std::memory_order_relaxed);
+        copy.depth[i] = sharedRoutes.depth[i].load(std::memory_order_relaxed);
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (sharedRoutes.sequence.load(std::memory_order_relaxed) != sequence)
+        return; // torn read, try again next block
+
+    routes = copy;
+    lastSequence = sequence;
+
+    routed.fill(false);
+    for (int r = 0; r < routes.numRoutes; ++r)
+        routed[(size_t) routes.destination[(size_t) r]] = true;
+}
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    ModulationMatrix.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Routes control sources (MIDI CCs, host-synced LFOs, envelope followers)
+// to parameters. Sources are evaluated every kControlInterval samples;
+// only destinations flagged as audio-rate get a per-sample ramp.
+//
+// Destinations are AudioProcessorParameter indices, and a modulation value
+// is an offset in normalised (0-1) parameter units.
+class ModulationMatrix
+{
+public:
+    //==============================================================================
+    static constexpr int kNumCcSources = 128;
+    static constexpr int kNumLfos = 2;
+    static constexpr int kNumEnvelopeFollowers = 2;
+
+    static constexpr int kFirstLfoSource = kNumCcSources;
+    static constexpr int kFirstEnvelopeFollowerSource = kFirstLfoSource + kNumLfos;
+    static constexpr int kNumSources = kFirstEnvelopeFollowerSource + kNumEnvelopeFollowers;
+
+    static constexpr int kMaxRoutes = 64;
+    static constexpr int kMaxDestinations = 32;
+    static constexpr int kControlInterval = 32;
+
+    enum class LfoShape { sine, triangle, saw, square };
+
+    //==============================================================================
+    ModulationMatrix();
+
+    // Call before prepareToPlay; audio-rate destinations get a per-sample buffer
+    void setAudioRate(int destination, bool shouldBeAudioRate);
+
+    // Call this in the plugin's prepareToPlay method
+    void prepareToPlay(double sampleRate, int samplesPerBlock);
+
+    //==============================================================================
+    // Message thread. Route edits are published to the audio thread at the
+    // start of the next block.
+    bool addRoute(int source, int destination, float depth);
+    void clearRoutes();
+    int getNumRoutes() const;
+
+    void setLfo(int lfoIndex, LfoShape shape, double beatsPerCycle);
+    LfoShape getLfoShape(int lfoIndex) const;
+    double getLfoBeatsPerCycle(int lfoIndex) const;
+
+    // Which input channels an envelope follower listens to
+    void setEnvelopeFollowerInput(int followerIndex, int firstChannel, int numChannels);
+
+    juce::ValueTree toValueTree() const;
+    void fromValueTree(const juce::ValueTree& tree);
+
+    //==============================================================================
+    // Any thread: feeds the CC sources
+    void handleMidiMessage(const juce::MidiMessage& message);
+
+    // Audio thread: evaluates sources and routes for this block, which must be
+    // no longer than the samplesPerBlock given to prepareToPlay. The input
+    // buffer is only read, for the envelope followers.
+    void process(const juce::AudioBuffer<float>& input,
+                 const juce::Optional<juce::AudioPlayHead::PositionInfo>& position);
+
+    // Modulation at the end of the last block
+    float getModulation(int destination) const { return currentValues[(size_t) destination]; }
+
+    // Per-sample modulation for the last block, or nullptr if the destination
+    // is not audio-rate or has no routes
+    const float* getAudioRateModulation(int destination) const;
+
+private:
+    //==============================================================================
+    // Audio-thread copy of the routes, laid out as parallel arrays so that
+    // evaluation is one tight loop with no per-route branching
+    struct Routes
+    {
+        std::array<int, kMaxRoutes> source {};
+        std::array<int, kMaxRoutes> destination {};
+        std::array<float, kMaxRoutes> depth {};
+        int numRoutes = 0;
+    };
+
+    // Message-thread side, published through a sequence counter
+    struct SharedRoutes
+    {
+        std::array<std::atomic<int>, kMaxRoutes> source;
+        std::array<std::atomic<int>, kMaxRoutes> destination;
+        std::array<std::atomic<float>, kMaxRoutes> depth;
+        std::atomic<int> numRoutes { 0 };
+        std::atomic<juce::uint32> sequence { 0 };
+    };
+
+    struct Lfo
+    {
+        std::atomic<int> shape { (int) LfoShape::sine };
+        std::atomic<double> beatsPerCycle { 1.0 };
+        double phase = 0.0;
+    };
+
+    struct EnvelopeFollower
+    {
+        std::atomic<int> firstChannel { 0 };
+        std::atomic<int> numChannels { 2 };
+        float level = 0.0f;
+    };
+
+    void writeSharedRoutes(const Routes& routes);
+    void pullSharedRoutes();
+    void evaluateSources(const juce::AudioBuffer<float>& input, int startSample, int numSamples);
+    static float lfoValue(LfoShape shape, double phase);
+
+    //==============================================================================
+    Routes routes;              // audio thread
+    Routes editRoutes;          // message thread
+    SharedRoutes sharedRoutes;
+    juce::uint32 lastSequence = 0;
+
+    std::array<std::atomic<float>, kNumCcSources> ccValues;
+    std::array<float, kNumSources> sourceValues {};
+
+    std::array<Lfo, kNumLfos> lfos;
+    std::array<EnvelopeFollower, kNumEnvelopeFollowers> followers;
+    float followerAttack = 0.0f, followerRelease = 0.0f;
+
+    std::array<float, kMaxDestinations> targetValues {};
+    std::array<float, kMaxDestinations> currentValues {};
+    std::array<bool, kMaxDestinations> audioRate {};
+    std::array<bool, kMaxDestinations> routed {};
+    std::array<int, kMaxDestinations> audioRateRow {};
+    std::vector<int> audioRateDestinations;
+    juce::AudioBuffer<float> audioRateBuffer;
+
+    double sampleRate = 44100.0;
+    double lastBpm = 120.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ModulationMatrix)
+};
@@ -0,0 +1,284 @@
+/*
+  ==============================================================================
+
+    OscControlReceiver.cpp
+
+  ==============================================================================
+*/
+
+#include "OscControlReceiver.h"
+#include "RealtimeFifo.h"
+
+//==============================================================================
+namespace
+{
+    constexpr int kMaxPacketSize = 1536;
+    constexpr int kMaxBundleDepth = 4;
+    constexpr const char* kAddressPrefix = "/set_gain/";
+
+    // FNV-1a
+    juce::uint32 hashAddress(const char* address, size_t length)
+    {
+        juce::uint32 hash = 2166136261u;
+        for (size_t i = 0; i < length; ++i)
+            hash = (hash ^ (juce::uint8) address[i]) * 16777619u;
+        return hash;
+    }
+
+    juce::uint32 readUint32(const char* data)
+    {
+        return juce::ByteOrder::bigEndianInt(data);
+    }
+
+    // Length of the OSC string at data, or -1 if it isn't terminated within size;
+    // padded tells how many bytes it takes up
+    int readString(const char* data, int size, int& padded)
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            if (data[i] == 0)
+            {
+                padded = (i + 4) & ~3;
+                return padded <= size ? i : -1;
+            }
+        }
+        return -1;
+    }
+
+    // '*' and '?' only; '[]' and '{}' lists are not supported
+    bool matchPattern(const char* pattern, const char* patternEnd, const char* text, const char* textEnd)
+    {
+        while (pattern < patternEnd)
+        {
+            if (*pattern == '*')
+            {
+                // A '*' never crosses a '/'
+                for (const char* t = text; t <= textEnd; ++t)
+                {
+                    if (matchPattern(pattern + 1, patternEnd, t, textEnd))
+                        return true;
+                    if (t < textEnd && *t == '/')
+                        break;
+                }
+                return false;
+            }
+
+            if (text == textEnd || (*pattern != '?' && *pattern != *text) || (*pattern == '?' && *text == '/'))
+                return false;
+
+            ++pattern;
+            ++text;
+        }
+        return text == textEnd;
+    }
+}
+
+//==============================================================================
+OscControlReceiver::OscControlReceiver(juce::AudioProcessor& processor)
+    : juce::Thread("OSC control receiver")
+{
+    for (auto* parameter : processor.getParameters())
+    {
+        if (auto* withId = dynamic_cast<juce::AudioProcessorParameterWithID*>(parameter))
+        {
+            const auto address = (juce::String(kAddressPrefix) + withId->paramID).toStdString();
+            addresses.push_back({ hashAddress(address.data(), address.size()), address, parameter->getParameterIndex() });
+        }
+    }
+
+    std::sort(addresses.begin(), addresses.end(), [](const Address& a, const Address& b) { return a.hash < b.hash; });
+}
+
+OscControlReceiver::~OscControlReceiver()
+{
+    setPort(0);
+}
+
+bool OscControlReceiver::setPort(int newPort)
+{
+    JUCE_ASSERT_MESSAGE_THREAD
+
+    // Shutting the socket down wakes the thread up
+    signalThreadShouldExit();
+    if (socket != nullptr)
+        socket->shutdown();
+
+    stopThread(1000);
+    socket.reset();
+    port = 0;
+
+    if (newPort <= 0)
+        return true;
+
+    socket = std::make_unique<juce::DatagramSocket>(false);
+
+    if (! socket->bindToPort(newPort, "127.0.0.1"))
+    {
+        socket.reset();
+        return false;
+    }
+
+    port = newPort;
+    startThread();
+    return true;
+}
+
+OscControlReceiver::Stats OscControlReceiver::getStats() const
+{
+    Stats stats;
+    stats.numMessages = numMessages.load(std::memory_order_relaxed);
+    stats.numUnmatched = numUnmatched.load(std::memory_order_relaxed);
+    stats.numDropped = numDropped.load(std::memory_order_relaxed);
+    return stats;
+}
+
+//==============================================================================
+void OscControlReceiver::run()
+{
+    char buffer[kMaxPacketSize];
+
+    while (! threadShouldExit())
+    {
+        if (socket->waitUntilReady(true, 100) <= 0)
+            continue;
+
+        const int size = socket->read(buffer, kMaxPacketSize, false);
+        if (size > 0)
+            handlePacket(buffer, size, 0);
+    }
+}
+
+void OscControlReceiver::handlePacket(const char* data, int size, int depth)
+{
+    if (size < 4 || (size & 3) != 0)
+        return;
+
+    if (data[0] == '/')
+    {
+        handleMessage(data, size);
+        return;
+    }
+
+    // "#bundle", 8-byte time tag, then size-prefixed elements; all applied now
+    if (size < 16 || std::memcmp(data, "#bundle", 8) != 0 || depth >= kMaxBundleDepth)
+        return;
+
+    for (int offset = 16; offset + 4 <= size;)
+    {
+        const int elementSize = (int) readUint32(data + offset);
+        offset += 4;
+
+        if (elementSize <= 0 || elementSize > size - offset)
+            return;
+
+        handlePacket(data + offset, elementSize, depth + 1);
+        offset += elementSize;
+    }
+}
+
+void OscControlReceiver::handleMessage(const char* data, int size)
+{
+    int addressSize = 0, tagsSize = 0;
+    const int addressLength = readString(data, size, addressSize);
+
+    const char* tags = data + addressSize;
+    const int tagsLength = addressLength < 0 ? -1 : readString(tags, size - addressSize, tagsSize);
+
+    const char* arguments = tags + tagsSize;
+    const int argumentsSize = size - addressSize - tagsSize;
+
+    if (tagsLength < 2 || tags[0] != ',')
+    {
+        numUnmatched.store(numUnmatched.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    // First argument only
+    float value = 0.0f;
+    bool hasValue = true;
+
+    switch (tags[1])
+    {
+        case 'f':
+            if ((hasValue = argumentsSize >= 4))
+            {
+                const auto bits = readUint32(arguments);
+                std::memcpy(&value, &bits, sizeof(value));
+            }
+            break;
+        case 'i':
+            if ((hasValue = argumentsSize >= 4))
+                value = (float) (juce::int32) readUint32(arguments);
+            break;
+        case 'd':
+            if ((hasValue = argumentsSize >= 8))
+            {
+                const auto bits = ((juce::uint64) readUint32(arguments) << 32) | readUint32(arguments + 4);
+                double d;
+                std::memcpy(&d, &bits, sizeof(d));
+                value = (float) d;
+            }
+            break;
+        case 'T': value = 1.0f; break;
+        case 'F': value = 0.0f; break;
+        default:  hasValue = false; break;
+    }
+
+    if (! hasValue || ! std::isfinite(value))
+    {
+        numUnmatched.store(numUnmatched.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    dispatch(data, (size_t) addressLength, juce::jlimit(0.0f, 1.0f, value));
+}
+
+void OscControlReceiver::dispatch(const char* address, size_t length, float value)
+{
+    const char* end = address + length;
+
+    if (std::find_if(address, end, [](char c) { return c == '*' || c == '?'; }) != end)
+    {
+        // A pattern from the sender; rare, so go through the whole table
+        bool matched = false;
+
+        for (const auto& entry : addresses)
+        {
+            if (matchPattern(address, end, entry.address.data(), entry.address.data() + entry.address.size()))
+            {
+                push(entry.parameterIndex, value);
+                matched = true;
+            }
+        }
+
+        if (! matched)
+            numUnmatched.store(numUnmatched.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    const auto hash = hashAddress(address, length);
+    auto it = std::lower_bound(addresses.begin(), addresses.end(), hash,
+                               [](const Address& entry, juce::uint32 h) { return entry.hash < h; });
+
+    for (; it != addresses.end() && it->hash == hash; ++it)
+    {
+        if (it->address.size() == length && std::memcmp(it->address.data(), address, length) == 0)
+        {
+            push(it->parameterIndex, value);
+            return;
+        }
+    }
+
+    numUnmatched.store(numUnmatched.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+void OscControlReceiver::push(int parameterIndex, float value)
+{
+    if (! RealtimeFifo::push(fifo, changes, Change { parameterIndex, value }))
+    {
+        numDropped.store(numDropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    numMessages.store(numMessages.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    OscControlReceiver.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Receives OSC from software controllers (tablet bridges, scripts) on a
+// local UDP port and turns it into parameter changes.
+//
+// The addresses are worked out once, up front: "/set_gain/<parameter id>"
+// for every parameter, hashed and sorted. A message is matched by hashing
+// its address and a binary search, with no strings built per message.
+// Patterns with '*' or '?' from the sender are matched against the table.
+//
+// The first argument (float, int, double, true/false) is the normalised
+// value, 0-1. Changes go through a wait-free FIFO to the audio thread, which
+// handles them like mapped MIDI: coalesced, then smoothed.
+//
+//   oscsend 127.0.0.1 9001 /set_gain/gain f 0.5
+class OscControlReceiver : private juce::Thread
+{
+public:
+    //==============================================================================
+    static constexpr int kCapacity = 512;
+    static constexpr int kDefaultPort = 9001;
+
+    explicit OscControlReceiver(juce::AudioProcessor& processor);
+    ~OscControlReceiver() override;
+
+    // Message thread. Binds to 127.0.0.1 only; 0 turns the receiver off.
+    // Returns false if the port couldn't be bound (e.g. another instance has it).
+    bool setPort(int port);
+    int getPort() const { return port; }
+    bool isListening() const { return isThreadRunning(); }
+
+    // Audio thread: calls fn(parameterIndex, normalisedValue) for every change
+    // received since the last call, oldest first
+    template <typename Function>
+    void forEachChange(Function&& fn)
+    {
+        const auto scope = fifo.read(fifo.getNumReady());
+
+        for (int i = 0; i < scope.blockSize1; ++i)
+            fn(changes[(size_t) (scope.startIndex1 + i)].parameterIndex, changes[(size_t) (scope.startIndex1 + i)].value);
+
+        for (int i = 0; i < scope.blockSize2; ++i)
+            fn(changes[(size_t) (scope.startIndex2 + i)].parameterIndex, changes[(size_t) (scope.startIndex2 + i)].value);
+    }
+
+    //==============================================================================
+    struct Stats
+    {
+        juce::uint64 numMessages = 0;   // matched and queued
+        juce::uint64 numUnmatched = 0;  // no such address, or no usable argument
+        juce::uint64 numDropped = 0;    // the audio thread fell behind
+    };
+
+    // Any thread
+    Stats getStats() const;
+
+private:
+    //==============================================================================
+    struct Address
+    {
+        juce::uint32 hash = 0;
+        std::string address;
+        int parameterIndex = -1;
+    };
+
+    struct Change
+    {
+        int parameterIndex = -1;
+        float value = 0.0f;
+    };
+
+    void run() override;
+    void handlePacket(const char* data, int size, int depth);
+    void handleMessage(const char* data, int size);
+    void dispatch(const char* address, size_t length, float value);
+    void push(int parameterIndex, float value);
+
+    // Built in the constructor, read-only afterwards
+    std::vector<Address> addresses;
+
+    juce::AbstractFifo fifo { kCapacity };
+    std::array<Change, kCapacity> changes;
+
+    std::unique_ptr<juce::DatagramSocket> socket;
+    int port = 0;
+
+    // Receiver thread only writes these
+    std::atomic<juce::uint64> numMessages { 0 }, numUnmatched { 0 }, numDropped { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(OscControlReceiver)
+};
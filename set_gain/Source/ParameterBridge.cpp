@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    ParameterBridge.cpp
+
+  ==============================================================================
+*/
+
+#include "ParameterBridge.h"
+
+//==============================================================================
+ParameterBridge::ParameterBridge(juce::AudioProcessor& processor)
+{
+    const auto& processorParameters = processor.getParameters();
+    jassert(processorParameters.size() <= kMaxParameters);
+
+    numParameters = juce::jmin(kMaxParameters, processorParameters.size());
+
+    for (int i = 0; i < numParameters; ++i)
+        parameters[(size_t) i] = dynamic_cast<juce::RangedAudioParameter*>(processorParameters[i]);
+
+    // Fast enough that the UI and host automation follow a knob smoothly
+    setHostUpdateRate(kDefaultHostUpdateRateHz);
+}
+
+ParameterBridge::~ParameterBridge()
+{
+    stopTimer();
+
+    for (int i = 0; i < numParameters; ++i)
+        if (slots[(size_t) i].gestureActive && parameters[(size_t) i] != nullptr)
+            parameters[(size_t) i]->endChangeGesture();
+}
+
+void ParameterBridge::setHostUpdateRate(int rateHz)
+{
+    hostUpdateRateHz = juce::jlimit(1, 1000, rateHz);
+    startTimerHz(hostUpdateRateHz);
+}
+
+//==============================================================================
+void ParameterBridge::push(int parameterIndex, float normalisedValue)
+{
+    if (! juce::isPositiveAndBelow(parameterIndex, numParameters))
+        return;
+
+    auto& slot = slots[(size_t) parameterIndex];
+    slot.value.store(normalisedValue, std::memory_order_relaxed);
+    slot.dspPending.store(true, std::memory_order_release);
+    slot.hostPending.store(true, std::memory_order_release);
+}
+
+float ParameterBridge::getDspValue(int parameterIndex)
+{
+    auto* parameter = parameters[(size_t) parameterIndex];
+    jassert(parameter != nullptr);
+    auto& slot = slots[(size_t) parameterIndex];
+
+    // Host automation or the UI moved the parameter: it wins again
+    const float parameterValue = parameter->getValue();
+    if (parameterValue != slot.lastParameterValue)
+    {
+        slot.lastParameterValue = parameterValue;
+        slot.usePushedValue = false;
+    }
+
+    if (slot.dspPending.exchange(false, std::memory_order_acquire))
+    {
+        slot.pushedValue = slot.value.load(std::memory_order_relaxed);
+        slot.usePushedValue = true;
+    }
+
+    return parameter->convertFrom0to1(slot.usePushedValue ? slot.pushedValue : parameterValue);
+}
+
+//==============================================================================
+void ParameterBridge::timerCallback()
+{
+    publishPending();
+}
+
+void ParameterBridge::publishPending()
+{
+    const auto now = juce::Time::getMillisecondCounter();
+
+    for (int i = 0; i < numParameters; ++i)
+    {
+        auto& slot = slots[(size_t) i];
+
+        auto* parameter = parameters[(size_t) i];
+
+        if (parameter == nullptr)
+            continue;
+
+        // A controller move is one gesture to the host, closed once the
+        // values have stopped coming for a moment
+        if (slot.gestureActive && now - slot.lastPublishMs > (juce::uint32) kGestureTimeoutMs)
+        {
+            parameter->endChangeGesture();
+            slot.gestureActive = false;
+        }
+
+        if (! slot.hostPending.exchange(false, std::memory_order_acquire))
+            continue;
+
+        // Controllers resend unchanged values (e.g. a periodic refresh); the host
+        // doesn't need to record those. Compared after snapping to the
+        // parameter's steps, so that bool and choice parameters match too.
+        const float value = parameter->convertTo0to1(parameter->convertFrom0to1(slot.value.load(std::memory_order_relaxed)));
+        if (value == parameter->getValue())
+            continue;
+
+        if (! slot.gestureActive)
+        {
+            parameter->beginChangeGesture();
+            slot.gestureActive = true;
+        }
+
+        parameter->setValueNotifyingHost(value);
+        slot.lastPublishMs = now;
+        published.store(true, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+  ==============================================================================
+
+    ParameterBridge.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Lets the audio and MIDI threads change parameters without calling
+// setValueNotifyingHost themselves. A pushed value reaches the DSP at the
+// next getDspValue() call; the host and the APVTS listeners (editor) are
+// told from the message thread by a timer, inside a change gesture that
+// stays open while the pushed values keep changing.
+//
+// The DSP side resolves "last writer wins" between pushed values and the
+// parameter itself: if the host or the UI moves the parameter after a push,
+// the parameter's value takes over again.
+class ParameterBridge : private juce::Timer
+{
+public:
+    //==============================================================================
+    static constexpr int kMaxParameters = 32;
+    static constexpr int kDefaultHostUpdateRateHz = 60;
+    static constexpr int kGestureTimeoutMs = 250;
+
+    explicit ParameterBridge(juce::AudioProcessor& processor);
+    ~ParameterBridge() override;
+
+    //==============================================================================
+    // Any thread, wait-free. Value is normalised 0-1.
+    void push(int parameterIndex, float normalisedValue);
+
+    // Audio thread: the value the DSP should use now, in the parameter's range
+    float getDspValue(int parameterIndex);
+
+    // Message thread. Caps how often pushed values reach the host and UI;
+    // anything pushed in between is folded into the next update.
+    void setHostUpdateRate(int rateHz);
+    int getHostUpdateRate() const { return hostUpdateRateHz; }
+
+    // Message thread: publish pending values to the host and listeners now
+    // instead of waiting for the timer
+    void publishPending();
+
+    // Message thread: true once after any pushed value was published
+    bool getAndClearPublished() { return published.exchange(false, std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    void timerCallback() override;
+
+    struct Slot
+    {
+        std::atomic<float> value { 0.0f };
+        std::atomic<bool> hostPending { false };
+        std::atomic<bool> dspPending { false };
+
+        // Audio thread only
+        float lastParameterValue = -1.0f;
+        float pushedValue = 0.0f;
+        bool usePushedValue = false;
+
+        // Message thread only
+        bool gestureActive = false;
+        juce::uint32 lastPublishMs = 0;
+    };
+
+    std::array<Slot, kMaxParameters> slots;
+    std::array<juce::RangedAudioParameter*, kMaxParameters> parameters {};
+    int numParameters = 0;
+    int hostUpdateRateHz = 0;
+    std::atomic<bool> published { false };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ParameterBridge)
+};
@@ -25,12 +25,240 @@ Test_filterAudioProcessorEditor::Test_filterAudioProcessorEditor (Test_filterAud
     connectionStatusLabel.setJustificationType(juce::Justification::centred);
     updateConnectionStatus(); // Initial status
     
+    // Set up DSP load label and CSV export
+    addAndMakeVisible(loadLabel);
+    loadLabel.setFont(juce::Font(12.0f));
+    loadLabel.setJustificationType(juce::Justification::centredLeft);
+    updateLoadStatus();
+    addAndMakeVisible(exportLoadButton);
+    exportLoadButton.onClick = [this]() { exportLoadCsv(); };
+    addAndMakeVisible(captureButton);
+    captureButton.setClickingTogglesState(true);
+    captureButton.setToggleState(audioProcessor.getMidiCapture().isRecording(), juce::dontSendNotification);
+    captureButton.onClick = [this]() { toggleMidiCapture(); };
+    addAndMakeVisible(playCaptureButton);
+    playCaptureButton.setClickingTogglesState(true);
+    playCaptureButton.setToggleState(audioProcessor.getCapturePlayer().isPlaying(), juce::dontSendNotification);
+    playCaptureButton.onClick = [this]() { toggleCapturePlayback(); };
+    
+    // Controller-to-audio latency, refreshed with the load
+    addAndMakeVisible(latencyLabel);
+    latencyLabel.setFont(juce::Font(12.0f));
+    latencyLabel.setJustificationType(juce::Justification::centredLeft);
+    updateLatencyStatus();
+    addAndMakeVisible(resetLatencyButton);
+    resetLatencyButton.onClick = [this]() { audioProcessor.getLatencyProfiler().reset(); };
+    
+    // How often controller moves reach the host's automation; item ids are the rate in Hz
+    addAndMakeVisible(hostRateBox);
+    for (const int rate : { 30, 60, 120, 250, 500, 1000 })
+        hostRateBox.addItem(juce::String(rate) + " Hz", rate);
+    if (hostRateBox.indexOfItemId(audioProcessor.getHostUpdateRate()) < 0)
+        hostRateBox.addItem(juce::String(audioProcessor.getHostUpdateRate()) + " Hz", audioProcessor.getHostUpdateRate());
+    hostRateBox.setSelectedId(audioProcessor.getHostUpdateRate(), juce::dontSendNotification);
+    hostRateBox.setTooltip("Rate at which MIDI-driven changes are sent to the host");
+    hostRateBox.onChange = [this]() { audioProcessor.setHostUpdateRate(hostRateBox.getSelectedId()); };
+    
+    // How quickly a silent controller shows as disconnected; item ids are the timeout in ms
+    addAndMakeVisible(sensingTimeoutBox);
+    for (const int timeout : { 150, 300, 500, 1000, 2000 })
+        sensingTimeoutBox.addItem(juce::String(timeout) + " ms", timeout);
+    if (sensingTimeoutBox.indexOfItemId(audioProcessor.getActiveSensingTimeout()) < 0)
+        sensingTimeoutBox.addItem(juce::String(audioProcessor.getActiveSensingTimeout()) + " ms", audioProcessor.getActiveSensingTimeout());
+    sensingTimeoutBox.setSelectedId(audioProcessor.getActiveSensingTimeout(), juce::dontSendNotification);
+    sensingTimeoutBox.setTooltip("How long a controller sending Active Sensing may go quiet before it counts as disconnected");
+    sensingTimeoutBox.onChange = [this]() { audioProcessor.setActiveSensingTimeout(sensingTimeoutBox.getSelectedId()); };
+    
+    // Set up MIDI learn for the gain
+    addAndMakeVisible(learnButton);
+    learnButton.setClickingTogglesState(true);
+    learnButton.onClick = [this]()
+    {
+        auto& learnTable = getSelectedLearnTable();
+        
+        if (learnButton.getToggleState())
+        {
+            MidiLearnTable::Mapping mapping;
+            mapping.parameterIndex = audioProcessor.getParameters().getParameter("gain")->getParameterIndex();
+            mapping.curve = (MidiLearnTable::Curve) (learnCurveBox.getSelectedId() - 1);
+            mapping.invert = learnInvertButton.getToggleState();
+            learnTable.startLearning(mapping);
+        }
+        else
+        {
+            learnTable.stopLearning();
+        }
+    };
+    
+    const auto addTableItems = [](juce::ComboBox& box)
+    {
+        box.addItem("Default", 1);
+        for (int table = 1; table <= MidiGainController::kMaxDeviceTables; ++table)
+            box.addItem("Table " + juce::String(table), table + 1);
+        box.setSelectedId(1, juce::dontSendNotification);
+    };
+    
+    addAndMakeVisible(learnTableBox);
+    addTableItems(learnTableBox);
+    learnTableBox.setTooltip("Learn into the host's default table or a device table");
+    learnTableBox.onChange = [this]()
+    {
+        // A learn in progress belongs to the table it was started on
+        for (int table = 0; table <= MidiGainController::kMaxDeviceTables; ++table)
+            audioProcessor.getMidiLearnTable(table).stopLearning();
+        learnButton.setToggleState(false, juce::dontSendNotification);
+    };
+    
+    addAndMakeVisible(learnCurveBox);
+    learnCurveBox.addItemList({ "Linear", "Log", "Audio taper" }, 1);
+    learnCurveBox.setSelectedId(1, juce::dontSendNotification);
+    learnCurveBox.onChange = [this]() { updateLearnCurve(); };
+    
+    addAndMakeVisible(learnInvertButton);
+    learnInvertButton.onClick = [this]() { updateLearnCurve(); };
+    
+    addAndMakeVisible(clearLearnButton);
+    clearLearnButton.onClick = [this]()
+    {
+        getSelectedLearnTable().clearMappingsFor(
+            audioProcessor.getParameters().getParameter("gain")->getParameterIndex());
+    };
+    
+    // Device to learn table assignment
+    addAndMakeVisible(deviceBox);
+    deviceBox.setTextWhenNothingSelected("No MIDI devices");
+    deviceBox.onChange = [this]() { updateDeviceTable(); };
+    
+    addAndMakeVisible(deviceTableBox);
+    addTableItems(deviceTableBox);
+    deviceTableBox.setTooltip("Learn table for messages from this device");
+    deviceTableBox.onChange = [this]()
+    {
+        if (deviceBox.getSelectedId() > 0)
+            audioProcessor.setDeviceTable(deviceBox.getText(), deviceTableBox.getSelectedId() - 1);
+    };
+    updateDeviceList();
+    
+    // Control group: "No group" is id 1, group n is id n + 1
+    addAndMakeVisible(groupBox);
+    groupBox.addItem("No group", 1);
+    for (int group = 1; group <= ControlBus::kNumGroups; ++group)
+        groupBox.addItem("Group " + juce::String(group), group + 1);
+    groupBox.setSelectedId(audioProcessor.getControlGroup() + 1, juce::dontSendNotification);
+    groupBox.setTooltip("Group n follows CC 7 (14-bit with CC 39) on MIDI channel n");
+    groupBox.onChange = [this]() { audioProcessor.setControlGroup(groupBox.getSelectedId() - 1); };
+    
+    const auto setUpTrimSlider = [this](juce::Slider& slider, double minimum, double maximum, float value,
+                                        const juce::String& tooltip)
+    {
+        addAndMakeVisible(slider);
+        slider.setSliderStyle(juce::Slider::LinearBar);
+        slider.setTextBoxStyle(juce::Slider::TextBoxLeft, false, 0, 0);
+        slider.setRange(minimum, maximum, 0.01);
+        slider.setValue(value, juce::dontSendNotification);
+        slider.setTooltip(tooltip);
+        slider.onValueChange = [this]()
+        {
+            audioProcessor.setGroupTrim((float) groupOffsetSlider.getValue(), (float) groupScaleSlider.getValue());
+        };
+    };
+    
+    setUpTrimSlider(groupOffsetSlider, -1.0, 1.0, audioProcessor.getGroupOffset(), "Group offset");
+    setUpTrimSlider(groupScaleSlider, 0.0, 2.0, audioProcessor.getGroupScale(), "Group scale");
+    
+    // Modulation routing: sources are the 128 CCs, then the LFOs, then the
+    // envelope followers; box ids are the source / parameter index + 1
+    auto& modMatrix = audioProcessor.getModulationMatrix();
+    
+    addAndMakeVisible(modSourceBox);
+    for (int cc = 0; cc < ModulationMatrix::kNumCcSources; ++cc)
+        modSourceBox.addItem("CC " + juce::String(cc), cc + 1);
+    for (int i = 0; i < ModulationMatrix::kNumLfos; ++i)
+        modSourceBox.addItem("LFO " + juce::String(i + 1), ModulationMatrix::kFirstLfoSource + i + 1);
+    for (int i = 0; i < ModulationMatrix::kNumEnvelopeFollowers; ++i)
+        modSourceBox.addItem("Env " + juce::String(i + 1), ModulationMatrix::kFirstEnvelopeFollowerSource + i + 1);
+    modSourceBox.setSelectedId(ModulationMatrix::kFirstLfoSource + 1, juce::dontSendNotification);
+    
+    addAndMakeVisible(modDestinationBox);
+    for (auto* parameter : audioProcessor.getParameterTree().getParameters(false))
+        if (parameter->getParameterIndex() < ModulationMatrix::kMaxDestinations)
+            modDestinationBox.addItem(parameter->getName(32), parameter->getParameterIndex() + 1);
+    modDestinationBox.setSelectedItemIndex(0, juce::dontSendNotification);
+    
+    addAndMakeVisible(modDepthSlider);
+    modDepthSlider.setSliderStyle(juce::Slider::LinearBar);
+    modDepthSlider.setRange(-1.0, 1.0, 0.01);
+    modDepthSlider.setValue(0.5, juce::dontSendNotification);
+    modDepthSlider.setTooltip("Modulation depth");
+    
+    addAndMakeVisible(addRouteButton);
+    addRouteButton.onClick = [this]() { addModulationRoute(); };
+    addAndMakeVisible(clearRoutesButton);
+    clearRoutesButton.onClick = [this]()
+    {
+        audioProcessor.getModulationMatrix().clearRoutes();
+        updateModulationStatus();
+    };
+    updateModulationStatus();
+    
+    for (int i = 0; i < ModulationMatrix::kNumLfos; ++i)
+    {
+        auto& shapeBox = lfoShapeBoxes[(size_t) i];
+        addAndMakeVisible(shapeBox);
+        shapeBox.addItemList({ "Sine", "Triangle", "Saw", "Square" }, 1);
+        shapeBox.setSelectedId((int) modMatrix.getLfoShape(i) + 1, juce::dontSendNotification);
+        shapeBox.setTooltip("LFO " + juce::String(i + 1) + " shape");
+        shapeBox.onChange = [this]() { updateLfos(); };
+        
+        auto& rateBox = lfoRateBoxes[(size_t) i];
+        addAndMakeVisible(rateBox);
+        for (int r = 0; r < (int) kLfoBeatsPerCycle.size(); ++r)
+        {
+            rateBox.addItem(juce::String(kLfoBeatsPerCycle[(size_t) r]) + " beat", r + 1);
+            if (kLfoBeatsPerCycle[(size_t) r] == modMatrix.getLfoBeatsPerCycle(i))
+                rateBox.setSelectedId(r + 1, juce::dontSendNotification);
+        }
+        rateBox.setTooltip("LFO " + juce::String(i + 1) + " beats per cycle");
+        rateBox.onChange = [this]() { updateLfos(); };
+    }
+    
+    addAndMakeVisible(envelopeBusBox);
+    envelopeBusBox.addItem("Env 2: Main", 1);
+    for (int bus = 1; bus < StemMixer::kMaxBuses; ++bus)
+        envelopeBusBox.addItem("Env 2: Stem " + juce::String(bus + 1), bus + 1);
+    envelopeBusBox.setSelectedId(audioProcessor.getEnvelopeFollowerBus(1) + 1, juce::dontSendNotification);
+    envelopeBusBox.onChange = [this]() { audioProcessor.setEnvelopeFollowerBus(1, envelopeBusBox.getSelectedId() - 1); };
+    
+    // OSC port, typed in; the status label says whether it could be bound
+    addAndMakeVisible(oscPortLabel);
+    oscPortLabel.setEditable(true);
+    oscPortLabel.setFont(juce::Font(12.0f));
+    oscPortLabel.setColour(juce::Label::outlineColourId, juce::Colours::darkgrey);
+    oscPortLabel.setTooltip("OSC port on 127.0.0.1, e.g. " + juce::String(OscControlReceiver::kDefaultPort));
+    const int oscPort = audioProcessor.getOscReceiver().getPort();
+    oscPortLabel.setText(oscPort > 0 ? juce::String(oscPort) : juce::String(), juce::dontSendNotification);
+    oscPortLabel.onTextChange = [this]()
+    {
+        audioProcessor.getOscReceiver().setPort(oscPortLabel.getText().getIntValue());
+        updateOscStatus();
+    };
+    
+    addAndMakeVisible(historyButton);
+    historyButton.setTooltip("Export the applied gain as a MIDI file (.mid) or breakpoints (.csv)");
+    historyButton.onClick = [this]() { exportGainHistory(); };
+    
+    addAndMakeVisible(oscStatusLabel);
+    oscStatusLabel.setFont(juce::Font(12.0f));
+    updateOscStatus();
+    
     // Connect slider to parameter using the getter method
     gainAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(
         audioProcessor.getParameters(), "gain", gainSlider);
     
-    // Start timer to check connection status periodically
-    startTimer(1000); // Check every second
+    // Timer drives all label updates, so nothing here runs on the audio thread;
+    // connection status is a few atomic reads and follows every tick, load
+    // status is refreshed once a second
+    startTimerHz(kTimerHz);
         
     
     // Add the MIDI indicator to the GUI
@@ -63,7 +291,7 @@ Test_filterAudioProcessorEditor::Test_filterAudioProcessorEditor (Test_filterAud
     audioProcessor.getParameters().addParameterListener("gain", this);
     
     //set window size
-    setSize (300, 150);
+    setSize (360, 340);
 }
 
 Test_filterAudioProcessorEditor::~Test_filterAudioProcessorEditor()
@@ -87,7 +315,65 @@ void Test_filterAudioProcessorEditor::paint (juce::Graphics& g)
 void Test_filterAudioProcessorEditor::resized()
 {
     
-    auto area = getLocalBounds().reduced(10);
+    auto bounds = getLocalBounds();
+    // OSC row below everything else
+    auto oscArea = bounds.removeFromBottom(24).reduced(10, 2);
+    oscPortLabel.setBounds(oscArea.removeFromLeft(60));
+    historyButton.setBounds(oscArea.removeFromRight(56));
+    oscStatusLabel.setBounds(oscArea.reduced(4, 0));
+    
+    // Latency row above it
+    auto latencyArea = bounds.removeFromBottom(22).reduced(10, 2);
+    hostRateBox.setBounds(latencyArea.removeFromRight(70));
+    sensingTimeoutBox.setBounds(latencyArea.removeFromRight(70));
+    resetLatencyButton.setBounds(latencyArea.removeFromRight(50));
+    latencyLabel.setBounds(latencyArea);
+    
+    // DSP load row above it
+    auto loadArea = bounds.removeFromBottom(24).reduced(10, 2);
+    exportLoadButton.setBounds(loadArea.removeFromRight(40));
+    playCaptureButton.setBounds(loadArea.removeFromRight(40));
+    captureButton.setBounds(loadArea.removeFromRight(40));
+    loadLabel.setBounds(loadArea);
+    
+    // MIDI learn row above it
+    auto learnArea = bounds.removeFromBottom(24).reduced(10, 2);
+    learnButton.setBounds(learnArea.removeFromLeft(60));
+    learnTableBox.setBounds(learnArea.removeFromLeft(80).reduced(4, 0));
+    clearLearnButton.setBounds(learnArea.removeFromRight(50));
+    learnInvertButton.setBounds(learnArea.removeFromRight(50));
+    learnCurveBox.setBounds(learnArea.reduced(4, 0));
+    
+    // Device table row above it
+    auto deviceArea = bounds.removeFromBottom(24).reduced(10, 2);
+    deviceTableBox.setBounds(deviceArea.removeFromRight(100));
+    deviceBox.setBounds(deviceArea.withTrimmedRight(4));
+    
+    // LFO row above it
+    auto lfoArea = bounds.removeFromBottom(24).reduced(10, 2);
+    const int lfoBoxWidth = lfoArea.getWidth() / 5;
+    for (int i = 0; i < ModulationMatrix::kNumLfos; ++i)
+    {
+        lfoShapeBoxes[(size_t) i].setBounds(lfoArea.removeFromLeft(lfoBoxWidth).reduced(1, 0));
+        lfoRateBoxes[(size_t) i].setBounds(lfoArea.removeFromLeft(lfoBoxWidth).reduced(1, 0));
+    }
+    envelopeBusBox.setBounds(lfoArea.reduced(1, 0));
+    
+    // Modulation route row above it
+    auto modArea = bounds.removeFromBottom(24).reduced(10, 2);
+    modSourceBox.setBounds(modArea.removeFromLeft(70));
+    modDestinationBox.setBounds(modArea.removeFromLeft(100).reduced(2, 0));
+    clearRoutesButton.setBounds(modArea.removeFromRight(46));
+    addRouteButton.setBounds(modArea.removeFromRight(40));
+    modDepthSlider.setBounds(modArea.reduced(2, 0));
+    
+    // Control group row above it
+    auto groupArea = bounds.removeFromBottom(24).reduced(10, 2);
+    groupBox.setBounds(groupArea.removeFromLeft(100));
+    groupScaleSlider.setBounds(groupArea.removeFromRight(80));
+    groupOffsetSlider.setBounds(groupArea.reduced(4, 0));
+    
+    auto area = bounds.reduced(10);
     // Status label at bottom
     connectionStatusLabel.setBounds(area.removeFromBottom(30));
     // Gain label at top
@@ -98,7 +384,7 @@ void Test_filterAudioProcessorEditor::resized()
     // Set button bounds (centered)
     // toggleButton.setBounds (200, 10, 100, 30);
     // Set slider bounds
-    gainSlider.setBounds(getLocalBounds());
+    gainSlider.setBounds(bounds);
     // set midi msg bounds
     midiMessageLabel.setBounds(10, getHeight() - 40, getWidth() - 20, 30);
 }
@@ -117,16 +403,24 @@ void  Test_filterAudioProcessorEditor::sliderValueChanged(juce::Slider *slider)
     }
 }
 
+void Test_filterAudioProcessorEditor::sliderDragStarted(juce::Slider *slider)
+{
+    if (slider == &gainSlider)
+        audioProcessor.setGainGestureActive(true);
+}
+
+void Test_filterAudioProcessorEditor::sliderDragEnded(juce::Slider *slider)
+{
+    if (slider == &gainSlider)
+        audioProcessor.setGainGestureActive(false);
+}
+
 void Test_filterAudioProcessorEditor::parameterChanged(const juce::String& parameterID, float newValue)
 {
+    // Can be called from the audio thread by host automation, so only flag it
+    // here; the slider itself follows the parameter through its attachment
     if (parameterID == "gain")
-    {
-        gainSlider.setValue(newValue, juce::dontSendNotification);
-    }
-    int controllerNumber = audioProcessor.getControllerNumber();
-    int controllerValue = audioProcessor.getcontrollerValue();
-    this->updateMIDIText(controllerNumber, controllerValue);
-    
+        gainChanged.store(true, std::memory_order_relaxed);
 }
 
 void Test_filterAudioProcessorEditor::updateMIDIText(int controllerNumber, int controllerValue)
@@ -138,7 +432,69 @@ void Test_filterAudioProcessorEditor::updateMIDIText(int controllerNumber, int c
 
 void Test_filterAudioProcessorEditor::timerCallback()
 {
+    if (gainChanged.exchange(false, std::memory_order_relaxed))
+        updateMIDIText(audioProcessor.getControllerNumber(), audioProcessor.getcontrollerValue());
+    
     updateConnectionStatus();
+    
+    if (++timerTicks >= kTimerHz)
+    {
+        timerTicks = 0;
+        updateLoadStatus();
+        updateLatencyStatus();
+        updateOscStatus();
+        updateModulationStatus();
+        updateDeviceList();
+    }
+    
+    if (playCaptureButton.getToggleState() && ! audioProcessor.getCapturePlayer().isPlaying() && ! choosingCapture)
+        playCaptureButton.setToggleState(false, juce::dontSendNotification);
+    
+    // The audio/MIDI thread clears the learn entry once a CC has been mapped
+    if (learnButton.getToggleState() && ! getSelectedLearnTable().isLearning())
+        learnButton.setToggleState(false, juce::dontSendNotification);
+}
+
+void Test_filterAudioProcessorEditor::updateLearnCurve()
+{
+    getSelectedLearnTable().setCurveFor(
+        audioProcessor.getParameters().getParameter("gain")->getParameterIndex(),
+        (MidiLearnTable::Curve) (learnCurveBox.getSelectedId() - 1),
+        learnInvertButton.getToggleState());
+}
+
+void Test_filterAudioProcessorEditor::addModulationRoute()
+{
+    if (modSourceBox.getSelectedId() == 0 || modDestinationBox.getSelectedId() == 0)
+        return;
+    
+    audioProcessor.getModulationMatrix().addRoute(modSourceBox.getSelectedId() - 1,
+                                                  modDestinationBox.getSelectedId() - 1,
+                                                  (float) modDepthSlider.getValue());
+    updateModulationStatus();
+}
+
+void Test_filterAudioProcessorEditor::updateLfos()
+{
+    auto& modMatrix = audioProcessor.getModulationMatrix();
+    
+    // A rate restored from a session that isn't in the list is left alone
+    for (int i = 0; i < ModulationMatrix::kNumLfos; ++i)
+    {
+        const int rate = lfoRateBoxes[(size_t) i].getSelectedId() - 1;
+        modMatrix.setLfo(i,
+                         (ModulationMatrix::LfoShape) juce::jmax(0, lfoShapeBoxes[(size_t) i].getSelectedId() - 1),
+                         rate >= 0 ? kLfoBeatsPerCycle[(size_t) rate] : modMatrix.getLfoBeatsPerCycle(i));
+    }
+}
+
+void Test_filterAudioProcessorEditor::updateModulationStatus()
+{
+    // Routes also change when the host restores a session, hence the timer refresh
+    const int numRoutes = audioProcessor.getModulationMatrix().getNumRoutes();
+    clearRoutesButton.setEnabled(numRoutes > 0);
+    clearRoutesButton.setTooltip(juce::String(numRoutes) + " modulation routes");
+    addRouteButton.setEnabled(numRoutes < ModulationMatrix::kMaxRoutes);
 }
 
 void Test_filterAudioProcessorEditor::updateConnectionStatus()
@@ -153,3 +509,179 @@ void Test_filterAudioProcessorEditor::updateConnectionStatus()
         juce::Label::textColourId,
         connected ? juce::Colours::green : juce::Colours::red);
 }
+
+void Test_filterAudioProcessorEditor::updateLoadStatus()
+{
+    auto snapshot = audioProcessor.getLoadProfiler().getSnapshot();
+    
+    loadLabel.setText(
+        "DSP p50 " + juce::String(snapshot.getPercentile(0.5), 0) + "%"
+        + "  p99 " + juce::String(snapshot.getPercentile(0.99), 0) + "%"
+        + "  max " + juce::String(snapshot.maxLoadPercent, 0) + "%"
+        + "  miss " + juce::String((juce::int64) snapshot.deadlineMisses),
+        juce::dontSendNotification);
+    
+    loadLabel.setColour(
+        juce::Label::textColourId,
+        snapshot.deadlineMisses > 0 ? juce::Colours::orange : juce::Colours::lightgrey);
+}
+
+void Test_filterAudioProcessorEditor::updateLatencyStatus()
+{
+    // Arrival to the sample where the gain changed, median / 99th percentile.
+    // Host MIDI has no arrival time, so it is timed from its block's start.
+    auto snapshot = audioProcessor.getLatencyProfiler().getSnapshot();
+    
+    const auto describe = [](const ControlLatencyProfiler::Histogram& h)
+    {
+        if (h.numEvents == 0)
+            return juce::String("-");
+        
+        return juce::String(h.getPercentile(0.5), 2) + "/" + juce::String(h.getPercentile(0.99), 2);
+    };
+    
+    latencyLabel.setText(
+        "CC ms dev " + describe(snapshot.effect[(size_t) ControlLatencyProfiler::Path::device])
+        + "  host@block " + describe(snapshot.effect[(size_t) ControlLatencyProfiler::Path::hostBlock]),
+        juce::dontSendNotification);
+}
+
+void Test_filterAudioProcessorEditor::updateDeviceList()
+{
+    const auto devices = audioProcessor.getOpenMidiDeviceNames();
+    if (devices == shownDevices)
+        return;
+    
+    // Keep the selection if that device is still there
+    const auto selected = deviceBox.getText();
+    shownDevices = devices;
+    deviceBox.clear(juce::dontSendNotification);
+    deviceBox.addItemList(devices, 1);
+    deviceBox.setSelectedId(devices.contains(selected) ? devices.indexOf(selected) + 1 : (devices.isEmpty() ? 0 : 1),
+                            juce::dontSendNotification);
+    updateDeviceTable();
+}
+
+void Test_filterAudioProcessorEditor::updateDeviceTable()
+{
+    deviceTableBox.setEnabled(deviceBox.getSelectedId() > 0);
+    deviceTableBox.setSelectedId(audioProcessor.getDeviceTable(deviceBox.getText()) + 1, juce::dontSendNotification);
+}
+
+void Test_filterAudioProcessorEditor::updateOscStatus()
+{
+    auto& receiver = audioProcessor.getOscReceiver();
+    
+    if (! receiver.isListening())
+    {
+        // A port was typed in but couldn't be bound
+        const bool failed = oscPortLabel.getText().getIntValue() > 0;
+        oscStatusLabel.setText(failed ? "OSC port busy" : "OSC off", juce::dontSendNotification);
+        oscStatusLabel.setColour(juce::Label::textColourId, failed ? juce::Colours::orange : juce::Colours::lightgrey);
+        return;
+    }
+    
+    const auto stats = receiver.getStats();
+    oscStatusLabel.setText("OSC msgs " + juce::String((juce::int64) stats.numMessages)
+                           + "  unmatched " + juce::String((juce::int64) stats.numUnmatched)
+                           + "  dropped " + juce::String((juce::int64) stats.numDropped),
+                           juce::dontSendNotification);
+    oscStatusLabel.setColour(juce::Label::textColourId, stats.numDropped > 0 ? juce::Colours::orange : juce::Colours::lightgrey);
+}
+
+void Test_filterAudioProcessorEditor::exportLoadCsv()
+{
+    saveCsv("Export DSP load histogram", "dsp_load.csv", audioProcessor.getLoadProfiler().getSnapshot().toCsv());
+}
+
+void Test_filterAudioProcessorEditor::saveCsv(const juce::String& title, const juce::String& fileName, const juce::String& csv)
+{
+    fileChooser = std::make_unique<juce::FileChooser>(
+        title,
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile(fileName),
+        "*.csv");
+    
+    fileChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles,
+                             [csv](const juce::FileChooser& chooser)
+                             {
+                                 auto file = chooser.getResult();
+                                 if (file != juce::File())
+                                     file.replaceWithText(csv);
+                             });
+}
+
+void Test_filterAudioProcessorEditor::exportGainHistory()
+{
+    fileChooser = std::make_unique<juce::FileChooser>(
+        "Export gain history",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("gain_history.mid"),
+        "*.mid;*.csv");
+    
+    auto points = audioProcessor.getGainHistory().getPoints();
+    
+    fileChooser->launchAsync(juce::FileBrowserComponent::saveMode | juce::FileBrowserComponent::canSelectFiles,
+                             [points](const juce::FileChooser& chooser)
+                             {
+                                 auto file = chooser.getResult();
+                                 if (file == juce::File())
+                                     return;
+                                 
+                                 // Breakpoints within half a percent of the applied gain
+                                 if (file.hasFileExtension("csv"))
+                                 {
+                                     file.replaceWithText(AutomationHistory::toBreakpointCsv(AutomationHistory::simplify(points, 0.005f)));
+                                     return;
+                                 }
+                                 
+                                 file.deleteFile();
+                                 juce::FileOutputStream stream(file);
+                                 if (stream.openedOk())
+                                     AutomationHistory::toMidiFile(points).writeTo(stream);
+                             });
+}
+
+void Test_filterAudioProcessorEditor::toggleMidiCapture()
+{
+    auto& capture = audioProcessor.getMidiCapture();
+    
+    if (! captureButton.getToggleState())
+    {
+        capture.stop();
+        return;
+    }
+    
+    // One file per session, next to the CSV exports
+    auto folder = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("VMS MIDI captures");
+    folder.createDirectory();
+    auto file = folder.getChildFile("capture_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".vmsm");
+    
+    if (! capture.start(file))
+        captureButton.setToggleState(false, juce::dontSendNotification);
+}
+
+void Test_filterAudioProcessorEditor::toggleCapturePlayback()
+{
+    auto& player = audioProcessor.getCapturePlayer();
+    
+    if (! playCaptureButton.getToggleState())
+    {
+        player.stop();
+        return;
+    }
+    
+    fileChooser = std::make_unique<juce::FileChooser>(
+        "Play MIDI capture",
+        juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("VMS MIDI captures"),
+        "*.vmsm");
+    
+    choosingCapture = true;
+    fileChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                             [this, &player](const juce::FileChooser& chooser)
+                             {
+                                 auto file = chooser.getResult();
+                                 if (file == juce::File() || ! player.start(file))
+                                     playCaptureButton.setToggleState(false, juce::dontSendNotification);
+                                 
+                                 choosingCapture = false;
+                             });
+}
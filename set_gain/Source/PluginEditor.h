@@ -63,6 +63,8 @@ public:
     void paint (juce::Graphics&) override;
     void resized() override;
     void sliderValueChanged(juce::Slider *slider) override;
+    void sliderDragStarted(juce::Slider *slider) override;
+    void sliderDragEnded(juce::Slider *slider) override;
     // Listener function for parameter changes
     void parameterChanged(const juce::String& parameterID, float newValue) override;
     
@@ -89,10 +91,78 @@ private:
     void timerCallback() override;
     // Update the connection status label
     void updateConnectionStatus();
+    // Update the DSP load label from the processor's profiler
+    void updateLoadStatus();
+    // Update the controller latency label, device vs host path
+    void updateLatencyStatus();
+    // Update the OSC label from the receiver's counters
+    void updateOscStatus();
+    // Save the load histogram as a CSV file
+    void exportLoadCsv();
+    void saveCsv(const juce::String& title, const juce::String& fileName, const juce::String& csv);
+    // Save the applied gain history as a MIDI file or simplified breakpoints
+    void exportGainHistory();
+    // Start/stop logging incoming MIDI to a capture file
+    void toggleMidiCapture();
+    // Pick a capture and play it into the processor, or stop playing
+    void toggleCapturePlayback();
+    // Push the curve/invert choice to every CC mapped to the gain
+    void updateLearnCurve();
+    MidiLearnTable& getSelectedLearnTable() { return audioProcessor.getMidiLearnTable(learnTableBox.getSelectedId() - 1); }
+    // Refill the device box when devices come and go, and show the table of the selected one
+    void updateDeviceList();
+    void updateDeviceTable();
+    // Route the chosen source to the chosen parameter at the slider's depth
+    void addModulationRoute();
+    // Apply both LFOs' shape and rate boxes
+    void updateLfos();
+    void updateModulationStatus();
     // Parameter attachment for the gain slider
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> gainAttachment;
     juce::Label gainLabel;
     juce::Label connectionStatusLabel;
+    juce::Label loadLabel;
+    juce::TextButton exportLoadButton { "CSV" };
+    juce::TextButton captureButton { "Rec" };
+    juce::TextButton playCaptureButton { "Play" };
+    bool choosingCapture = false;
+    juce::Label latencyLabel;
+    juce::TextButton resetLatencyButton { "Reset" };
+    juce::ComboBox hostRateBox;
+    juce::ComboBox sensingTimeoutBox;
+    std::unique_ptr<juce::FileChooser> fileChooser;
+    
+    // MIDI learn for the gain: next CC moved is mapped to it, in the chosen
+    // table (box id = table + 1)
+    juce::TextButton learnButton { "Learn" };
+    juce::ComboBox learnTableBox;
+    juce::TextButton clearLearnButton { "Clear" };
+    juce::ComboBox learnCurveBox;
+    juce::ToggleButton learnInvertButton { "Inv" };
+    
+    // Which learn table each open device uses (box id = table + 1)
+    juce::ComboBox deviceBox, deviceTableBox;
+    juce::StringArray shownDevices;
+    
+    // Control group shared with other instances, and this instance's trim
+    juce::ComboBox groupBox;
+    juce::Slider groupOffsetSlider, groupScaleSlider;
+    
+    // Modulation routes: source (CC, LFO, envelope) to parameter at a depth
+    juce::ComboBox modSourceBox, modDestinationBox;
+    juce::Slider modDepthSlider;
+    juce::TextButton addRouteButton { "Add" };
+    juce::TextButton clearRoutesButton { "Clear" };
+    
+    // Shape and rate of both LFOs, and the bus envelope 2 follows
+    std::array<juce::ComboBox, ModulationMatrix::kNumLfos> lfoShapeBoxes, lfoRateBoxes;
+    static constexpr std::array<double, 7> kLfoBeatsPerCycle { 0.25, 0.5, 1.0, 2.0, 4.0, 8.0, 16.0 };
+    juce::ComboBox envelopeBusBox;
+    
+    // OSC input port (blank = off) and what has arrived on it
+    juce::Label oscPortLabel;
+    juce::Label oscStatusLabel;
+    juce::TextButton historyButton { "History" };
 
     // Declare a toggle button
     juce::ToggleButton toggleButton;
@@ -101,6 +171,11 @@ private:
     
     bool shouldReduceVolume = false;
     MidiActivityIndicator midiIndicator;
+    
+    // Set by parameterChanged, consumed by the timer on the message thread
+    std::atomic<bool> gainChanged { false };
+    static constexpr int kTimerHz = 30;
+    int timerTicks = 0;
 
     // Function to handle toggle button changes
     void toggleButtonChanged();
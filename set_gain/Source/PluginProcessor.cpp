@@ -8,33 +8,83 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "ControllerSysEx.h"
 #include "MidiGainController.h"
 
 //==============================================================================
-Test_filterAudioProcessor::Test_filterAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       ),
-       parameters (*this, nullptr, "PARAMETERS",
-       {
-           std::make_unique<juce::AudioParameterFloat>("gain", "Gain", 0.0f, 1.0f, 0.5f)
-       })
+static juce::AudioProcessor::BusesProperties createBusesProperties()
+{
+    juce::AudioProcessor::BusesProperties buses;
+   #if ! JucePlugin_IsMidiEffect
+    #if ! JucePlugin_IsSynth
+    buses = buses.withInput  ("Input",  juce::AudioChannelSet::stereo(), true);
+    
+    // Extra stems for submix use, off until the host enables them
+    for (int bus = 2; bus <= StemMixer::kMaxBuses; ++bus)
+        buses = buses.withInput ("Stem " + juce::String(bus), juce::AudioChannelSet::stereo(), false);
+    #endif
+    buses = buses.withOutput ("Output", juce::AudioChannelSet::stereo(), true);
+   #endif
+    return buses;
+}
+#endif
+
+//==============================================================================
+Test_filterAudioProcessor::Test_filterAudioProcessor(bool connectControlSources)
+#ifndef JucePlugin_PreferredChannelConfigurations
+     : AudioProcessor (createBusesProperties()),
+       parameters (*this, nullptr, "PARAMETERS", createParameterLayout())
 #endif
 {
-    midiController = std::make_unique<MidiGainController>(parameters);
-    startMidiInput();  // Start listening to MIDI input
-    startTimer(2000);
+    if (connectControlSources)
+        sources = std::make_unique<ControlSources>();
+    
+    midiController = std::make_unique<MidiGainController>(parameters, sources != nullptr ? &sources->midiDevices.getObject() : nullptr);
+    
+    // The DSP reads every parameter through the bridge, by index
+    for (int bus = 0; bus < StemMixer::kMaxBuses; ++bus)
+    {
+        busGainIndex[(size_t) bus] = parameters.getParameter("busGain" + juce::String(bus + 1))->getParameterIndex();
+        busMuteIndex[(size_t) bus] = parameters.getParameter("busMute" + juce::String(bus + 1))->getParameterIndex();
+    }
+    mixParameterIndex = parameters.getParameter("mix")->getParameterIndex();
+    
+    // Gain modulation is applied per sample to avoid zipper noise
+    gainParameterIndex = parameters.getParameter("gain")->getParameterIndex();
+    modMatrix.setAudioRate(gainParameterIndex, true);
+    
+    if (sources != nullptr)
+        sources->midiDevices->addCallback(this);  // Start listening to MIDI input, from where the controllers are
 }
 
 Test_filterAudioProcessor::~Test_filterAudioProcessor()
 {
-    stopMidiInput(); // Stop listening to MIDI input when destroyed
+    if (sources != nullptr)
+        sources->midiDevices->removeCallback(this); // Stop listening to MIDI input when destroyed
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout Test_filterAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    // Master gain stays first so its parameter index doesn't change
+    layout.add(std::make_unique<juce::AudioParameterFloat>("gain", "Gain", 0.0f, 1.0f, 0.5f));
+    
+    for (int bus = 1; bus <= StemMixer::kMaxBuses; ++bus)
+    {
+        layout.add(std::make_unique<juce::AudioParameterFloat>("busGain" + juce::String(bus),
+                                                               "Stem " + juce::String(bus) + " Gain",
+                                                               0.0f, 1.0f, 1.0f));
+        layout.add(std::make_unique<juce::AudioParameterBool>("busMute" + juce::String(bus),
+                                                              "Stem " + juce::String(bus) + " Mute",
+                                                              false));
+    }
+    
+    // Parallel dry/wet, fully wet by default
+    layout.add(std::make_unique<juce::AudioParameterFloat>("mix", "Mix", 0.0f, 1.0f, 1.0f));
+    
+    return layout;
 }
 
 //==============================================================================
@@ -106,6 +156,18 @@ void Test_filterAudioProcessor::prepareToPlay (double sampleRate, int samplesPer
     // initialisation that you need..
     // Initialize MIDI controller
     midiController->prepareToPlay();
+    loadProfiler.prepareToPlay(sampleRate, samplesPerBlock);
+    latencyProfiler.prepareToPlay(sampleRate);
+    maxBlockSize = juce::jmax(1, samplesPerBlock);
+    modMatrix.prepareToPlay(sampleRate, samplesPerBlock);
+    stemMixer.prepareToPlay(sampleRate);
+    dryWet.prepareToPlay(sampleRate, samplesPerBlock, getMainBusNumOutputChannels(), getLatencySamples());
+    
+    deviceMidi.prepareToPlay(sampleRate, samplesPerBlock);
+    
+    gainSmoothed.reset(sampleRate, 0.02);
+    gainSmoothed.setCurrentAndTargetValue(parameterBridge.getDspValue(gainParameterIndex));
+    gainHistory.prepareToPlay(sampleRate);
 }
 
 void Test_filterAudioProcessor::releaseResources()
@@ -133,6 +195,14 @@ bool Test_filterAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
    #if ! JucePlugin_IsSynth
     if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
         return false;
+    
+    // Stem buses can be off, mono or stereo
+    for (int bus = 1; bus < layouts.inputBuses.size(); ++bus)
+    {
+        auto set = layouts.getChannelSet(true, bus);
+        if (!set.isDisabled() && set != juce::AudioChannelSet::mono() && set != juce::AudioChannelSet::stereo())
+            return false;
+    }
    #endif
 
     return true;
@@ -142,6 +212,7 @@ bool Test_filterAudioProcessor::isBusesLayoutSupported (const BusesLayout& layou
 
 void Test_filterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
+    ProcessLoadProfiler::ScopedBlock scopedLoad(loadProfiler, buffer.getNumSamples());
     juce::ScopedNoDenormals noDenormals;
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
@@ -151,30 +222,270 @@ void Test_filterAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
     
     //==============================================================================
     
-    juce::MidiBuffer::Iterator it(midiMessages);
-    juce::MidiMessage message;
-    int samplePosition;
-
-    while (it.getNextEvent(message, samplePosition))
+    // Host MIDI arrives with the block
+    latencyProfiler.beginBlock(juce::Time::getMillisecondCounterHiRes() * 0.001);
+    midiCapture.recordHost(midiMessages);
+    // A capture being played back adds its host events here
+    capturePlayer.renderNextBlock(midiMessages, buffer.getNumSamples());
+    
+    // Device MIDI placed at its sample offsets; host MIDI that duplicates it
+    // is skipped below, reading the host buffer in place
+    deviceMidi.renderNextBlock(midiMessages, buffer.getNumSamples());
+    
+    // Map controller messages to parameter changes and keep only the last
+    // one per parameter; modulation sources work at control rate, so they
+    // take the CCs up front. Both streams are in sample order, so merge them.
+    controlEvents.clear();
+    readControlGroup();
+    
+    // OSC and daemon changes count as arriving at the start of the block
+    const auto addBlockStartChange = [this](int parameterIndex, float value)
+    {
+        if (parameterIndex != gainParameterIndex || getControlGroup() == 0)
+            controlEvents.add(parameterIndex, value, 0);
+    };
+    
+    if (sources != nullptr)
+        sources->sharedControl.forEachChange(addBlockStartChange);
+    oscReceiver.forEachChange(addBlockStartChange);
+    
+    int deviceEvent = 0;
+    
+    const auto handleDeviceEventsBefore = [this, &deviceEvent](int samplePosition)
     {
-        if (midiController)
+        for (; deviceEvent < deviceMidi.getNumDeviceEvents(); ++deviceEvent)
         {
-            midiController->handleIncomingMidiMessage(nullptr, message);
+            const auto& event = deviceMidi.getDeviceEvent(deviceEvent);
+            if (event.samplePosition >= samplePosition)
+                break;
+            
+            handleBlockMessage(event.getMessage(), event.deviceSlot, event.samplePosition, event.arrivalTime);
         }
+    };
+    
+    int hostIndex = 0;
+    
+    for (const auto metadata : midiMessages)
+    {
+        if (deviceMidi.isHostDuplicate(hostIndex++))
+            continue;
+        
+        handleDeviceEventsBefore(metadata.samplePosition);
+        handleBlockMessage(metadata.getMessage(), -1, metadata.samplePosition, latencyProfiler.getBlockStartSeconds());
     }
     
-    // Get current gain value from ValueTreeState
-    float gainValue = *parameters.getRawParameterValue("gain");
+    handleDeviceEventsBefore(std::numeric_limits<int>::max());
+    
+    // Gain changes are applied at their sample position below, everything
+    // else from the start of the block
+    for (int i = 0; i < controlEvents.getNumChanges(); ++i)
+    {
+        const auto& change = controlEvents.getChange(i);
+        if (change.parameterIndex != gainParameterIndex)
+            parameterBridge.push(change.parameterIndex, change.normalisedValue);
+    }
+    
+    // The DSP stages are sized for the block size given to prepareToPlay; a
+    // host that sends more than that is processed in pieces of that size.
+    // Only the first piece locks the LFOs to the playhead, later ones follow on.
+    auto* playHead = getPlayHead();
+    const auto position = playHead != nullptr ? playHead->getPosition()
+                                              : juce::Optional<juce::AudioPlayHead::PositionInfo>();
+    gainHistory.setPlayhead(samplesProcessed, position);
+    
+    const int numSamples = buffer.getNumSamples();
+    const auto* gainChange = controlEvents.findChange(gainParameterIndex);
+    const int gainChangePosition = gainChange != nullptr ? juce::jlimit(0, numSamples, gainChange->samplePosition) : -1;
+    
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+    {
+        const int length = juce::jmin(maxBlockSize, numSamples - start);
+        const bool isLast = start + length == numSamples;
+        const bool changeHere = gainChangePosition >= start && (gainChangePosition < start + length || isLast);
+        
+        juce::AudioBuffer<float> piece(buffer.getArrayOfWritePointers(), buffer.getNumChannels(), start, length);
+        processAudio(piece, start, changeHere ? gainChange : nullptr,
+                     start == 0 ? position : juce::Optional<juce::AudioPlayHead::PositionInfo>());
+    }
+}
+
+void Test_filterAudioProcessor::processAudio(juce::AudioBuffer<float>& buffer, int blockOffset,
+                                             const ControlEventCoalescer::Change* gainChange,
+                                             const juce::Optional<juce::AudioPlayHead::PositionInfo>& position)
+{
+    const int numSamples = buffer.getNumSamples();
+    const int numMainOutputChannels = getMainBusNumOutputChannels();
     
-    // Apply gain to audio
-        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+    // Evaluate modulation sources on the dry input
+    for (int i = 0; i < ModulationMatrix::kNumEnvelopeFollowers; ++i)
+    {
+        const int bus = envelopeFollowerBus[(size_t) i].load(std::memory_order_relaxed);
+        auto* inputBus = getBus(true, bus);
+        
+        if (inputBus != nullptr && inputBus->isEnabled())
+            modMatrix.setEnvelopeFollowerInput(i, getChannelIndexInProcessBlockBuffer(true, bus, 0), inputBus->getNumberOfChannels());
+        else
+            modMatrix.setEnvelopeFollowerInput(i, 0, 0);
+    }
+    
+    modMatrix.process(buffer, position);
+    
+    // Everything but the gain takes its modulation at control rate
+    const auto modulated = [this](int parameterIndex)
+    {
+        return juce::jlimit(0.0f, 1.0f, parameterBridge.getDspValue(parameterIndex) + modMatrix.getModulation(parameterIndex));
+    };
+    
+    // Sum the enabled input buses into the main output
+    std::array<StemMixer::BusChannels, StemMixer::kMaxBuses> busChannels {};
+    
+    for (int bus = 0; bus < StemMixer::kMaxBuses; ++bus)
+    {
+        auto* inputBus = getBus(true, bus);
+        if (inputBus != nullptr && inputBus->isEnabled())
+            busChannels[(size_t) bus] = { getChannelIndexInProcessBlockBuffer(true, bus, 0), inputBus->getNumberOfChannels() };
+        
+        stemMixer.setBusGain(bus, modulated(busGainIndex[(size_t) bus]), modulated(busMuteIndex[(size_t) bus]) >= 0.5f);
+    }
+    
+    stemMixer.process(buffer, numMainOutputChannels, busChannels);
+    
+    // Keep the summed input as the dry path, delayed by the latency we report
+    // (0 at the moment: no stage adds any, so this is a plain parallel mix)
+    dryWet.setLatency(getLatencySamples());
+    dryWet.pushDry(buffer, numMainOutputChannels);
+    
+    // Apply gain to audio, split where a MIDI gain change lands so it takes
+    // effect at its own sample position
+    auto* gainModulation = modMatrix.getAudioRateModulation(gainParameterIndex);
+    const int split = gainChange != nullptr ? juce::jlimit(0, numSamples, gainChange->samplePosition - blockOffset) : numSamples;
+    
+    // Current gain, including MIDI changes not yet published to the host.
+    // If it moved without a MIDI change, the parameter itself was set.
+    const float gainTarget = parameterBridge.getDspValue(gainParameterIndex);
+    if (gainTarget != lastGainTarget)
+        gainSource = gainGestureActive.load(std::memory_order_relaxed) ? AutomationHistory::Source::ui
+                                                                       : AutomationHistory::Source::host;
+    
+    lastGainTarget = gainTarget;
+    gainSmoothed.setTargetValue(gainTarget);
+    applyGain(buffer, 0, split, numMainOutputChannels, gainModulation);
+    
+    if (gainChange != nullptr)
+    {
+        gainHistory.record(samplesProcessed + split, gainSmoothed.getCurrentValue(), gainSource);
+        gainSource = AutomationHistory::Source::midi;
+        
+        parameterBridge.push(gainParameterIndex, gainChange->normalisedValue);
+        lastGainTarget = parameterBridge.getDspValue(gainParameterIndex);
+        gainSmoothed.setTargetValue(lastGainTarget);
+        applyGain(buffer, split, numSamples - split, numMainOutputChannels, gainModulation);
+        latencyProfiler.gainApplied(blockOffset + split);
+    }
+    
+    gainHistory.record(samplesProcessed + numSamples, gainSmoothed.getCurrentValue(), gainSource);
+    samplesProcessed += numSamples;
+    
+    // Blend the processed signal with the latency-aligned dry input
+    dryWet.mixWet(buffer, numMainOutputChannels, modulated(mixParameterIndex));
+}
+
+void Test_filterAudioProcessor::handleBlockMessage(const juce::MidiMessage& message, int deviceSlot, int samplePosition,
+                                                   double arrivalTime)
+{
+    modMatrix.handleMidiMessage(message);
+    
+    if (midiController == nullptr)
+        return;
+    
+    // Each device goes through its own parser and mapping table
+    int parameterIndex = -1;
+    float value = 0.0f;
+    const bool mapped = deviceSlot < 0 ? midiController->mapMessage(message, parameterIndex, value)
+                                       : midiController->mapDeviceMessage(deviceSlot, message, parameterIndex, value);
+    
+    // In a control group the bus drives the gain
+    if (! mapped || (parameterIndex == gainParameterIndex && getControlGroup() > 0))
+        return;
+    
+    controlEvents.add(parameterIndex, value, samplePosition);
+    
+    if (parameterIndex == gainParameterIndex)
+        latencyProfiler.addGainEvent(deviceSlot < 0 ? ControlLatencyProfiler::Path::hostBlock : ControlLatencyProfiler::Path::device,
+                                     arrivalTime);
+}
+
+void Test_filterAudioProcessor::readControlGroup()
+{
+    const int group = getControlGroup();
+    juce::uint32 sequence = 0;
+    float value = 0.0f;
+    
+    // Joining a group picks up its current value; after that only changes count
+    const bool changed = group != lastGroup;
+    lastGroup = group;
+    
+    if (group == 0 || sources == nullptr || ! sources->controlBus->read(group, sequence, value) || (sequence == lastGroupSequence && ! changed))
+        return;
+    
+    lastGroupSequence = sequence;
+    controlEvents.add(gainParameterIndex, juce::jlimit(0.0f, 1.0f, value * getGroupScale() + getGroupOffset()), 0);
+}
+
+void Test_filterAudioProcessor::setEnvelopeFollowerBus(int follower, int bus)
+{
+    if (juce::isPositiveAndBelow(follower, ModulationMatrix::kNumEnvelopeFollowers))
+        envelopeFollowerBus[(size_t) follower].store(juce::jlimit(0, StemMixer::kMaxBuses - 1, bus), std::memory_order_relaxed);
+}
+
+void Test_filterAudioProcessor::setActiveSensingTimeout(int milliseconds)
+{
+    activeSensingTimeoutMs.store(juce::jmax(1, milliseconds), std::memory_order_relaxed);
+    
+    if (sources != nullptr)
+        sources->midiDevices->setActiveSensingTimeout(getActiveSensingTimeout());
+}
+
+void Test_filterAudioProcessor::setGroupTrim(float offset, float scale)
+{
+    groupOffset.store(juce::jlimit(-1.0f, 1.0f, offset), std::memory_order_relaxed);
+    groupScale.store(juce::jlimit(0.0f, 2.0f, scale), std::memory_order_relaxed);
+}
+
+void Test_filterAudioProcessor::applyGain(juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                                          int numChannels, const float* gainModulation)
+{
+    if (gainModulation != nullptr || gainSmoothed.isSmoothing())
+    {
+        // Per-sample gain, worked out once per chunk for all channels
+        for (int start = startSample; start < startSample + numSamples; start += kGainChunkSize)
         {
-            auto* channelData = buffer.getWritePointer(channel);
-            for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+            const int count = juce::jmin(kGainChunkSize, startSample + numSamples - start);
+            float gains[kGainChunkSize];
+            
+            for (int sample = 0; sample < count; ++sample)
+            {
+                gains[sample] = gainSmoothed.getNextValue();
+                if (gainModulation != nullptr)
+                    gains[sample] = juce::jlimit(0.0f, 1.0f, gains[sample] + gainModulation[start + sample]);
+            }
+            
+            for (int channel = 0; channel < numChannels; ++channel)
+                juce::FloatVectorOperations::multiply(buffer.getWritePointer(channel, start), gains, count);
+        }
+    }
+    else
+    {
+        const float gainValue = gainSmoothed.getTargetValue();
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* channelData = buffer.getWritePointer(channel, startSample);
+            for (int sample = 0; sample < numSamples; ++sample)
             {
                 channelData[sample] *= gainValue;
             }
         }
+    }
 }
 
 //==============================================================================
@@ -191,15 +502,71 @@ juce::AudioProcessorEditor* Test_filterAudioProcessor::createEditor()
 //==============================================================================
 void Test_filterAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
 {
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
+    // Parameters plus the modulation routing and MIDI-learn mappings, stored as XML
+    auto state = parameters.copyState();
+    auto modulation = modMatrix.toValueTree();
+    for (int i = 0; i < ModulationMatrix::kNumEnvelopeFollowers; ++i)
+        modulation.setProperty("envelopeBus" + juce::String(i + 1), getEnvelopeFollowerBus(i), nullptr);
+    state.appendChild(modulation, nullptr);
+    state.appendChild(midiController->getLearnTable().toValueTree(*this), nullptr);
+    state.appendChild(midiController->devicesToValueTree(*this), nullptr);
+    state.appendChild(juce::ValueTree("CONTROL_GROUP", { { "group", getControlGroup() },
+                                                         { "offset", getGroupOffset() },
+                                                         { "scale", getGroupScale() } }), nullptr);
+    state.appendChild(juce::ValueTree("OSC", { { "port", oscReceiver.getPort() } }), nullptr);
+    state.appendChild(juce::ValueTree("HOST_UPDATES", { { "rate", getHostUpdateRate() } }), nullptr);
+    state.appendChild(juce::ValueTree("ACTIVE_SENSING", { { "timeoutMs", getActiveSensingTimeout() } }), nullptr);
+    
+    std::unique_ptr<juce::XmlElement> xml(state.createXml());
+    copyXmlToBinary(*xml, destData);
 }
 
 void Test_filterAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
 {
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
+    std::unique_ptr<juce::XmlElement> xml(getXmlFromBinary(data, sizeInBytes));
+    
+    if (xml == nullptr || !xml->hasTagName(parameters.state.getType()))
+        return;
+    
+    auto state = juce::ValueTree::fromXml(*xml);
+    auto modulation = state.getChildWithName("MODULATION");
+    
+    modMatrix.fromValueTree(modulation);
+    for (int i = 0; i < ModulationMatrix::kNumEnvelopeFollowers; ++i)
+        setEnvelopeFollowerBus(i, modulation.getProperty("envelopeBus" + juce::String(i + 1), i));
+    state.removeChild(modulation, nullptr);
+    
+    // Older sessions have no MIDI_LEARN child and keep the default CC #7 mapping
+    auto midiLearn = state.getChildWithName("MIDI_LEARN");
+    midiController->getLearnTable().fromValueTree(midiLearn, *this);
+    state.removeChild(midiLearn, nullptr);
+    
+    auto midiDeviceTables = state.getChildWithName("MIDI_DEVICES");
+    midiController->devicesFromValueTree(midiDeviceTables, *this);
+    state.removeChild(midiDeviceTables, nullptr);
+    
+    auto controlGroupState = state.getChildWithName("CONTROL_GROUP");
+    setControlGroup(controlGroupState.getProperty("group", 0));
+    setGroupTrim(controlGroupState.getProperty("offset", 0.0f), controlGroupState.getProperty("scale", 1.0f));
+    state.removeChild(controlGroupState, nullptr);
+    
+    auto oscState = state.getChildWithName("OSC");
+    oscReceiver.setPort(oscState.getProperty("port", 0));
+    state.removeChild(oscState, nullptr);
+    
+    auto hostUpdates = state.getChildWithName("HOST_UPDATES");
+    setHostUpdateRate(hostUpdates.getProperty("rate", ParameterBridge::kDefaultHostUpdateRateHz));
+    state.removeChild(hostUpdates, nullptr);
+    
+    auto activeSensing = state.getChildWithName("ACTIVE_SENSING");
+    setActiveSensingTimeout(activeSensing.getProperty("timeoutMs", MidiDeviceService::kDefaultActiveSensingTimeoutMs));
+    state.removeChild(activeSensing, nullptr);
+    parameters.replaceState(state);
+    
+    // The knobs can't be moved to match the session, so where they are wins
+    // over the saved values, through the mappings that were just loaded
+    if (sources != nullptr)
+        sources->midiDevices->sendDeviceStates(this);
 }
 
 //==============================================================================
@@ -212,46 +579,49 @@ juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
 int Test_filterAudioProcessor::getControllerNumber() { return controllerNumber; }
 int Test_filterAudioProcessor::getcontrollerValue() { return controllerValue; }
 
-void Test_filterAudioProcessor::startMidiInput()
+juce::StringArray Test_filterAudioProcessor::getOpenMidiDeviceNames() const
 {
-    auto availableDevices = juce::MidiInput::getAvailableDevices();
-    if (!availableDevices.isEmpty())
-    {
-        auto deviceID = availableDevices[0].identifier;
-        midiInputDevice = juce::MidiInput::openDevice(deviceID, this); // Now correctly assigned
-
-        if (midiInputDevice)
-            midiInputDevice->start();
-    }
-}
-
-void Test_filterAudioProcessor::stopMidiInput()
-{
-    if (midiInputDevice)
+    juce::StringArray names;
+    
+    if (sources == nullptr)
+        return names;
+    
+    for (int slot = 0; slot < MidiDeviceService::kMaxDevices; ++slot)
     {
-        midiInputDevice->stop();
-        midiInputDevice.reset(); // Properly cleanup using unique_ptr
+        const auto info = sources->midiDevices->getDeviceInfo(slot);
+        if (info.name.isNotEmpty())
+            names.add(info.name);
     }
+    
+    return names;
 }
 
-void Test_filterAudioProcessor::handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message)
+void Test_filterAudioProcessor::handleDeviceMidi(int deviceSlot, const juce::MidiMessage& message)
 {
-    if (midiController)
+    // MIDI thread: queued with its arrival time and applied in the next block
+    midiCapture.recordDevice(message, deviceSlot);
+    
+    // A state dump is unpacked into the CCs it stands for, so it goes through
+    // the device's mapping like the controls themselves
+    const bool isStateDump = ControllerSysEx::forEachValue(message, ControllerSysEx::stateDump,
+                                                           [this, deviceSlot](int channel, int controller, int value)
     {
-        midiController->handleIncomingMidiMessage(nullptr, message);
-    }
+        deviceMidi.push(juce::MidiMessage::controllerEvent(channel, controller, value), deviceSlot);
+    });
+    
+    if (! isStateDump)
+        deviceMidi.push(message, deviceSlot);
 }
 
-void Test_filterAudioProcessor::timerCallback()
+void Test_filterAudioProcessor::handleDeviceState(int deviceSlot, const MidiDeviceService::ControllerValues& values)
 {
-    auto availableDevices = juce::MidiInput::getAvailableDevices();
-
-    if (!availableDevices.isEmpty() && !midiInputDevice) // If a device is available but not started
-    {
-        startMidiInput();
-    }
-    else if (availableDevices.isEmpty() && midiInputDevice) // If no devices are available but we're still running
+    // Applied straight through the bridge rather than queued for the audio
+    // thread: there may be no block for a while (prepareToPlay flushes the
+    // queue), and a whole device's state can be more than the queue holds
+    midiController->forEachDeviceStateValue(deviceSlot, values, [this](int parameterIndex, float value)
     {
-        stopMidiInput();
-    }
+        // In a control group the bus drives the gain
+        if (parameterIndex != gainParameterIndex || getControlGroup() == 0)
+            parameterBridge.push(parameterIndex, value);
+    });
 }
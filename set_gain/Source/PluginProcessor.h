@@ -10,17 +10,32 @@
 
 #include <JuceHeader.h>
 #include "MidiGainController.h"
+#include "ProcessLoadProfiler.h"
+#include "ModulationMatrix.h"
+#include "StemMixer.h"
+#include "DryWetMix.h"
+#include "ParameterBridge.h"
+#include "DeviceMidiQueue.h"
+#include "ControlEventCoalescer.h"
+#include "MidiCapture.h"
+#include "ControlLatencyProfiler.h"
+#include "ControlBus.h"
+#include "OscControlReceiver.h"
+#include "SharedControlChannel.h"
+#include "AutomationHistory.h"
 
 //==============================================================================
 /**
 */
 class Test_filterAudioProcessor  : public juce::AudioProcessor,
-                                   public juce::MidiInputCallback,
-                                   public juce::Timer
+                                   public MidiDeviceService::Callback
 {
 public:
     //==============================================================================
-    Test_filterAudioProcessor();
+    // Without control sources the instance only hears the MIDI passed to
+    // processBlock: no device MIDI, control groups or control daemon. Used
+    // to measure the control path (see the SetGainTests benchmarks).
+    explicit Test_filterAudioProcessor(bool connectControlSources = true);
     ~Test_filterAudioProcessor() override;
 
     //==============================================================================
@@ -66,12 +81,50 @@ public:
     bool getMidiActivity() const { return midiActivityDetected; }
     bool isMidiControllerConnected() const
         {
-            return midiController->isDeviceConnected();
+            return midiController->isDeviceConnected() || (sources != nullptr && sources->sharedControl.isConnected());
         }
-    void startMidiInput();
-    void stopMidiInput();
-    void handleIncomingMidiMessage(juce::MidiInput* source, const juce::MidiMessage& message) override;
-    void timerCallback() override;
+    ProcessLoadProfiler& getLoadProfiler() { return loadProfiler; }
+    ControlLatencyProfiler& getLatencyProfiler() { return latencyProfiler; }
+    ModulationMatrix& getModulationMatrix() { return modMatrix; }
+    // Input bus an envelope follower listens to; follower n starts on bus n
+    void setEnvelopeFollowerBus(int follower, int bus);
+    int getEnvelopeFollowerBus(int follower) const { return envelopeFollowerBus[(size_t) follower].load(std::memory_order_relaxed); }
+    ParameterBridge& getParameterBridge() { return parameterBridge; }
+    // How often MIDI-driven parameter changes are published to the host and
+    // UI, 1-1000 Hz. Message thread; saved with the session.
+    void setHostUpdateRate(int rateHz) { parameterBridge.setHostUpdateRate(rateHz); }
+    int getHostUpdateRate() const { return parameterBridge.getHostUpdateRate(); }
+    // How long a device that sends Active Sensing may go quiet before it
+    // counts as disconnected. Message thread; saved with the session. The
+    // devices are shared by every instance, so the value set last applies.
+    void setActiveSensingTimeout(int milliseconds);
+    int getActiveSensingTimeout() const { return activeSensingTimeoutMs.load(std::memory_order_relaxed); }
+    // Table 0 is the host's and the default for devices; see MidiGainController
+    MidiLearnTable& getMidiLearnTable(int table = 0) { return midiController->getLearnTable(table); }
+    // Message thread: the devices the shared service has open, and the
+    // learn table each of them uses (0 = the default table)
+    juce::StringArray getOpenMidiDeviceNames() const;
+    void setDeviceTable(const juce::String& deviceName, int table) { midiController->setDeviceTable(deviceName, table); }
+    int getDeviceTable(const juce::String& deviceName) const { return midiController->getDeviceTable(deviceName); }
+    MidiCaptureRecorder& getMidiCapture() { return midiCapture; }
+    MidiCapturePlayer& getCapturePlayer() { return capturePlayer; }
+    
+    // Control group 1-16 shared with other instances, 0 for none. While in a
+    // group the gain follows the group's controller (CC 7 on the group's
+    // channel, see ControlBus) through this instance's trim (value * scale +
+    // offset) instead of its own MIDI mapping.
+    void setControlGroup(int group) { controlGroup.store(juce::jlimit(0, ControlBus::kNumGroups, group), std::memory_order_relaxed); }
+    int getControlGroup() const { return controlGroup.load(std::memory_order_relaxed); }
+    void setGroupTrim(float offset, float scale);
+    float getGroupOffset() const { return groupOffset.load(std::memory_order_relaxed); }
+    float getGroupScale() const { return groupScale.load(std::memory_order_relaxed); }
+    OscControlReceiver& getOscReceiver() { return oscReceiver; }
+    AutomationHistory& getGainHistory() { return gainHistory; }
+    // Set by the editor while the gain slider is being dragged, so the
+    // history can tell UI moves from host automation
+    void setGainGestureActive(bool active) { gainGestureActive.store(active, std::memory_order_relaxed); }
+    void handleDeviceMidi(int deviceSlot, const juce::MidiMessage& message) override;
+    void handleDeviceState(int deviceSlot, const MidiDeviceService::ControllerValues& values) override;
 
     
     
@@ -79,17 +132,104 @@ private:
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Test_filterAudioProcessor)
     //==============================================================================
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+    // Gain over part of the block, per sample while smoothing or modulated
+    void applyGain(juce::AudioBuffer<float>& buffer, int startSample, int numSamples,
+                   int numChannels, const float* gainModulation);
+    // Modulation, stems, gain and mix for at most maxBlockSize samples starting
+    // blockOffset into the block; gainChange is the MIDI gain change if it lands here
+    void processAudio(juce::AudioBuffer<float>& buffer, int blockOffset, const ControlEventCoalescer::Change* gainChange,
+                      const juce::Optional<juce::AudioPlayHead::PositionInfo>& position);
+    // Modulation and MIDI mapping for one message of the block; deviceSlot is -1 for the host
+    void handleBlockMessage(const juce::MidiMessage& message, int deviceSlot, int samplePosition, double arrivalTime);
+    // Gain change from the control group, if its value moved since the last block
+    void readControlGroup();
+    //==============================================================================
     double rawVolume;
     bool shouldReduceVolume = false;
     bool midiActivityDetected = false;
 
     juce::AudioProcessorValueTreeState parameters;
     
+    // Audio/MIDI-thread parameter changes, published to host and UI from the message thread
+    ParameterBridge parameterBridge { *this };
+    
     int controllerNumber;
     int controllerValue;
     
+    // Everything outside the host that drives the parameters. Declared before
+    // the controller, which uses the device service until it's destroyed.
+    struct ControlSources
+    {
+        // Shared by all instances; delivers device MIDI to handleDeviceMidi
+        juce::SharedResourcePointer<MidiDeviceService> midiDevices;
+        
+        // Shared by all instances; one controller drives every instance in a group
+        juce::SharedResourcePointer<ControlBus> controlBus;
+        
+        // Values from a control daemon that owns the hardware, if one is running
+        SharedControlReader sharedControl;
+    };
+    
+    std::unique_ptr<ControlSources> sources;
+    
     // The MIDI controller
     std::unique_ptr<MidiGainController> midiController;
-    std::unique_ptr<juce::MidiInput> midiInputDevice;
+    
+    // Device MIDI, timestamped on arrival and placed in the block next to the host's
+    DeviceMidiQueue deviceMidi;
+    
+    // At most one MIDI-driven change per parameter per block
+    ControlEventCoalescer controlEvents;
+    
+    std::atomic<int> activeSensingTimeoutMs { MidiDeviceService::kDefaultActiveSensingTimeoutMs };
+    
+    // Control group, read from sources->controlBus
+    std::atomic<int> controlGroup { 0 };
+    std::atomic<float> groupOffset { 0.0f }, groupScale { 1.0f };
+    int lastGroup = 0;                  // audio thread only
+    juce::uint32 lastGroupSequence = 0; // audio thread only
+    
+    // Software controllers over OSC, off until a port is set
+    OscControlReceiver oscReceiver { *this };
+    
+    // Optional log of all incoming MIDI, for reproducing problems offline
+    MidiCaptureRecorder midiCapture;
+    
+    // Plays a capture back through the same paths as live input
+    MidiCapturePlayer capturePlayer { deviceMidi };
+    
+    // Per-block timing against the real-time deadline
+    ProcessLoadProfiler loadProfiler;
+    
+    // Controller arrival to gain change, device vs host path
+    ControlLatencyProfiler latencyProfiler;
+    
+    // CC / LFO / envelope modulation of the parameters
+    ModulationMatrix modMatrix;
+    std::array<std::atomic<int>, ModulationMatrix::kNumEnvelopeFollowers> envelopeFollowerBus { { 0, 1 } };
+    int gainParameterIndex = 0;
+    int maxBlockSize = 512;
+    
+    // Smooths gain steps from host automation and (14-bit) MIDI
+    juce::SmoothedValue<float> gainSmoothed;
+    
+    // The gain as applied, and what last moved it. Controller paths (MIDI,
+    // OSC, control group, daemon) all count as MIDI.
+    AutomationHistory gainHistory;
+    AutomationHistory::Source gainSource = AutomationHistory::Source::host;
+    std::atomic<bool> gainGestureActive { false };
+    float lastGainTarget = -1.0f;
+    juce::int64 samplesProcessed = 0;
+    static constexpr int kGainChunkSize = 64;
+    
+    // Per-stem gain and mute, summed into the main output
+    StemMixer stemMixer;
+    std::array<int, StemMixer::kMaxBuses> busGainIndex {};
+    std::array<int, StemMixer::kMaxBuses> busMuteIndex {};
+    
+    // Latency-compensated parallel mix
+    DryWetMix dryWet;
+    int mixParameterIndex = 0;
 
 };
@@ -0,0 +1,97 @@
+/*
+  ==============================================================================
+
+    ProcessLoadProfiler.cpp
+
+  ==============================================================================
+*/
+
+#include "ProcessLoadProfiler.h"
+
+//==============================================================================
+ProcessLoadProfiler::ProcessLoadProfiler()
+{
+    clearCounters();
+}
+
+void ProcessLoadProfiler::prepareToPlay(double sampleRate, int samplesPerBlock)
+{
+    currentSampleRate.store(sampleRate, std::memory_order_relaxed);
+    currentBlockSize.store(samplesPerBlock, std::memory_order_relaxed);
+
+    // load% = elapsedSeconds / (numSamples / sampleRate) * 100
+    //       = elapsedTicks * sampleRate * 100 / (ticksPerSecond * numSamples)
+    percentPerTickSample = sampleRate > 0.0
+        ? sampleRate * 100.0 / (double) juce::Time::getHighResolutionTicksPerSecond()
+        : 0.0;
+
+    clearCounters();
+}
+
+void ProcessLoadProfiler::addBlock(juce::int64 elapsedTicks, int numSamples)
+{
+    if (resetRequested.exchange(false, std::memory_order_relaxed))
+        clearCounters();
+
+    if (numSamples <= 0 || percentPerTickSample <= 0.0)
+        return;
+
+    const double loadPercent = (double) elapsedTicks * percentPerTickSample / (double) numSamples;
+    loadHistogram.add(loadPercent, 1.0);
+
+    // Single writer, so plain load/store is enough and avoids locked instructions
+    if (loadPercent > 100.0)
+        deadlineMisses.store(deadlineMisses.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+ProcessLoadProfiler::Snapshot ProcessLoadProfiler::getSnapshot() const
+{
+    Snapshot s;
+    s.counts = loadHistogram.getCounts();
+    s.numBlocks = loadHistogram.getNumValues();
+    s.deadlineMisses = deadlineMisses.load(std::memory_order_relaxed);
+    s.maxLoadPercent = loadHistogram.getMaxValue();
+    s.sampleRate = currentSampleRate.load(std::memory_order_relaxed);
+    s.blockSize = currentBlockSize.load(std::memory_order_relaxed);
+    return s;
+}
+
+void ProcessLoadProfiler::clearCounters()
+{
+    loadHistogram.clear();
+    deadlineMisses.store(0, std::memory_order_relaxed);
+}
+
+//==============================================================================
+double ProcessLoadProfiler::Snapshot::getPercentile(double fraction) const
+{
+    return RealtimeHistogram<kNumBins>::getPercentile(counts, fraction, 1.0);
+}
+
+double ProcessLoadProfiler::Snapshot::getBudgetMilliseconds() const
+{
+    return sampleRate > 0.0 ? 1000.0 * blockSize / sampleRate : 0.0;
+}
+
+juce::String ProcessLoadProfiler::Snapshot::toCsv() const
+{
+    juce::String csv;
+
+    csv << "sample_rate,block_size,budget_ms,blocks,deadline_misses,p50_pct,p90_pct,p99_pct,max_pct\n"
+        << sampleRate << "," << blockSize << "," << getBudgetMilliseconds() << ","
+        << (juce::int64) numBlocks << "," << (juce::int64) deadlineMisses << ","
+        << getPercentile(0.5) << "," << getPercentile(0.9) << "," << getPercentile(0.99) << ","
+        << maxLoadPercent << "\n\n";
+
+    csv << "load_pct_from,load_pct_to,blocks\n";
+    for (int i = 0; i < kNumBins; ++i)
+    {
+        if (counts[(size_t) i] == 0)
+            continue;
+
+        csv << i << "," << (i == kNumBins - 1 ? juce::String("inf") : juce::String(i + 1)) << ","
+            << (juce::int64) counts[(size_t) i] << "\n";
+    }
+
+    return csv;
+}
@@ -0,0 +1,90 @@
+/*
+  ==============================================================================
+
+    ProcessLoadProfiler.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "RealtimeHistogram.h"
+
+// Measures how much of the real-time budget each processBlock call uses.
+// The audio thread is the only writer; the editor reads snapshots from the
+// message thread, so everything shared is a relaxed atomic.
+class ProcessLoadProfiler
+{
+public:
+    //==============================================================================
+    // Histogram of block load in percent of the budget, 1% per bin.
+    // The last bin collects everything at or above kMaxLoadPercent.
+    static constexpr int kMaxLoadPercent = 200;
+    static constexpr int kNumBins = kMaxLoadPercent + 1;
+
+    struct Snapshot
+    {
+        std::array<juce::uint64, kNumBins> counts {};
+        juce::uint64 numBlocks = 0;
+        juce::uint64 deadlineMisses = 0;
+        double maxLoadPercent = 0.0;
+        double sampleRate = 0.0;
+        int blockSize = 0;
+
+        // Load in percent below which the given fraction (0-1) of blocks fall
+        double getPercentile(double fraction) const;
+        double getBudgetMilliseconds() const;
+        juce::String toCsv() const;
+    };
+
+    //==============================================================================
+    ProcessLoadProfiler();
+
+    // Call this in the plugin's prepareToPlay method
+    void prepareToPlay(double sampleRate, int samplesPerBlock);
+
+    // Audio thread only
+    void addBlock(juce::int64 elapsedTicks, int numSamples);
+
+    // Message thread: read the current state, or ask the audio thread to clear it
+    Snapshot getSnapshot() const;
+    void reset() { resetRequested.store(true, std::memory_order_relaxed); }
+
+    //==============================================================================
+    // Times the enclosing scope and records it as one block
+    class ScopedBlock
+    {
+    public:
+        ScopedBlock(ProcessLoadProfiler& p, int samples)
+            : profiler(p), numSamples(samples), startTicks(juce::Time::getHighResolutionTicks()) {}
+
+        ~ScopedBlock()
+        {
+            profiler.addBlock(juce::Time::getHighResolutionTicks() - startTicks, numSamples);
+        }
+
+    private:
+        ProcessLoadProfiler& profiler;
+        const int numSamples;
+        const juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedBlock)
+    };
+
+private:
+    //==============================================================================
+    void clearCounters();
+
+    RealtimeHistogram<kNumBins> loadHistogram;
+    std::atomic<juce::uint64> deadlineMisses { 0 };
+    std::atomic<bool> resetRequested { false };
+
+    std::atomic<double> currentSampleRate { 0.0 };
+    std::atomic<int> currentBlockSize { 0 };
+
+    // Ticks-to-percent factor for one sample, updated in prepareToPlay
+    double percentPerTickSample = 0.0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ProcessLoadProfiler)
+};
@@ -0,0 +1,36 @@
+/*
+  ==============================================================================
+
+    RealtimeFifo.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// The single-producer side of an AbstractFifo over a fixed array, as used by
+// every queue that a realtime thread writes into. Never blocks or allocates:
+// a full FIFO drops the item, and the caller decides what that costs.
+//
+// Shared with the gainPlugin project, whose feedback queue works the same way.
+namespace RealtimeFifo
+{
+    // Copies item into the next free slot of items. Returns false if the
+    // FIFO was full and the item was dropped.
+    template <typename Container, typename Item>
+    bool push(juce::AbstractFifo& fifo, Container& items, const Item& item)
+    {
+        const auto scope = fifo.write(1);
+
+        if (scope.blockSize1 > 0)
+            items[(size_t) scope.startIndex1] = item;
+        else if (scope.blockSize2 > 0)
+            items[(size_t) scope.startIndex2] = item;
+        else
+            return false;
+
+        return true;
+    }
+}
@@ -0,0 +1,101 @@
+/*
+  ==============================================================================
+
+    RealtimeHistogram.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Fixed-width bins counted by one thread (the audio thread) and read from
+// another (the editor). Everything shared is a relaxed atomic, and with a
+// single writer each count is a plain load/store rather than a locked
+// read-modify-write. Used by the profilers for their histograms.
+template <int NumBins>
+class RealtimeHistogram
+{
+public:
+    //==============================================================================
+    using Counts = std::array<juce::uint64, NumBins>;
+
+    RealtimeHistogram() { clear(); }
+
+    // Writer thread only. Bin i holds [i, i + 1) * binWidth; values past the
+    // range land in the last bin, negative ones in the first.
+    void add(double value, double binWidth)
+    {
+        value = juce::jmax(0.0, value);
+        const int bin = juce::jlimit(0, NumBins - 1, (int) (value / binWidth));
+
+        increment(bins[(size_t) bin]);
+        increment(numValues);
+
+        if (value > maxValue.load(std::memory_order_relaxed))
+            maxValue.store(value, std::memory_order_relaxed);
+    }
+
+    // Writer thread only, or while it isn't running
+    void clear()
+    {
+        for (auto& b : bins)
+            b.store(0, std::memory_order_relaxed);
+
+        numValues.store(0, std::memory_order_relaxed);
+        maxValue.store(0.0, std::memory_order_relaxed);
+    }
+
+    //==============================================================================
+    // Any thread
+    Counts getCounts() const
+    {
+        Counts counts;
+        for (size_t i = 0; i < counts.size(); ++i)
+            counts[i] = bins[i].load(std::memory_order_relaxed);
+        return counts;
+    }
+
+    juce::uint64 getNumValues() const { return numValues.load(std::memory_order_relaxed); }
+    double getMaxValue() const        { return maxValue.load(std::memory_order_relaxed); }
+
+    // Value below which the given fraction (0-1) of the counts fall, as the
+    // upper edge of the bin where it is reached
+    static double getPercentile(const Counts& counts, double fraction, double binWidth)
+    {
+        // The bins are read one by one while the writer keeps going, so use
+        // the sum actually seen rather than the value count
+        juce::uint64 total = 0;
+        for (auto c : counts)
+            total += c;
+
+        if (total == 0)
+            return 0.0;
+
+        const auto target = (juce::uint64) std::ceil(juce::jlimit(0.0, 1.0, fraction) * (double) total);
+        juce::uint64 running = 0;
+
+        for (int i = 0; i < NumBins; ++i)
+        {
+            running += counts[(size_t) i];
+            if (running >= target && running > 0)
+                return (i + 1) * binWidth;
+        }
+
+        return (NumBins - 1) * binWidth;
+    }
+
+private:
+    //==============================================================================
+    static void increment(std::atomic<juce::uint64>& counter)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<juce::uint64>, NumBins> bins;
+    std::atomic<juce::uint64> numValues { 0 };
+    std::atomic<double> maxValue { 0.0 };
+
+    JUCE_DECLARE_NON_COPYABLE(RealtimeHistogram)
+};
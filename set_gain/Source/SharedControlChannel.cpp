@@ -0,0 +1,199 @@
+/*
+  ==============================================================================
+
+    SharedControlChannel.cpp
+
+  ==============================================================================
+*/
+
+#include "SharedControlChannel.h"
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+ #define VMS_SHARED_CONTROL 1
+#else
+ #define VMS_SHARED_CONTROL 0
+#endif
+
+//==============================================================================
+namespace
+{
+    constexpr int kCheckIntervalMs = 1000;
+}
+
+//==============================================================================
+SharedControlReader::SharedControlReader()
+{
+   #if VMS_SHARED_CONTROL
+    map();
+    startTimer(kCheckIntervalMs);
+   #endif
+}
+
+SharedControlReader::~SharedControlReader()
+{
+    stopTimer();
+    current.store(nullptr, std::memory_order_release);
+
+   #if VMS_SHARED_CONTROL
+    for (const auto& mapping : mappings)
+        munmap(mapping.address, mapping.size);
+   #endif
+}
+
+void SharedControlReader::timerCallback()
+{
+    const auto* layout = current.load(std::memory_order_relaxed);
+
+    if (layout == nullptr)
+    {
+        map();
+        return;
+    }
+
+    const bool alive = SharedControl::isAlive(*layout);
+
+    // A silent daemon may have been restarted with a fresh segment
+    if (! alive && map())
+        return;
+
+    setConnected(alive);
+}
+
+void SharedControlReader::setConnected(bool isNowConnected)
+{
+    if (connected.exchange(isNowConnected, std::memory_order_relaxed) != isNowConnected)
+        sendSynchronousChangeMessage();
+}
+
+bool SharedControlReader::map()
+{
+   #if VMS_SHARED_CONTROL
+    const int fd = shm_open(SharedControl::kSegmentName, O_RDONLY, 0);
+    if (fd < 0)
+        return false;
+
+    struct stat info;
+    const auto size = sizeof(SharedControl::Layout);
+
+    if (fstat(fd, &info) != 0 || (size_t) info.st_size < size
+        || (! mappings.isEmpty() && mappings.getLast().inode == (juce::uint64) info.st_ino))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    // Read-only: a reader can't damage the segment, and the daemon can't
+    // take the mapping away from under the audio thread
+    void* address = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+
+    if (address == MAP_FAILED)
+        return false;
+
+    const auto* layout = static_cast<const SharedControl::Layout*>(address);
+
+    if (layout->magic != SharedControl::kMagic || layout->version != SharedControl::kVersion)
+    {
+        munmap(address, size);
+        return false;
+    }
+
+    mappings.add({ address, size, (juce::uint64) info.st_ino });
+    current.store(layout, std::memory_order_release);
+    setConnected(SharedControl::isAlive(*layout));
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+//==============================================================================
+SharedControlWriter::~SharedControlWriter()
+{
+    close();
+}
+
+bool SharedControlWriter::open()
+{
+   #if VMS_SHARED_CONTROL
+    close();
+
+    const int fd = shm_open(SharedControl::kSegmentName, O_CREAT | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    const auto size = sizeof(SharedControl::Layout);
+    void* address = ftruncate(fd, (off_t) size) == 0 ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+                                                     : MAP_FAILED;
+    ::close(fd);
+
+    if (address == MAP_FAILED)
+        return false;
+
+    layout = static_cast<SharedControl::Layout*>(address);
+
+    // A segment left by a previous run keeps its values; carry on from its
+    // sequence numbers so readers don't mistake new values for old ones
+    if (layout->magic == SharedControl::kMagic && layout->version == SharedControl::kVersion)
+    {
+        for (size_t i = 0; i < sequences.size(); ++i)
+            sequences[i] = (juce::uint32) (layout->slots[i].load(std::memory_order_relaxed) >> 32);
+    }
+    else
+    {
+        // Fresh (zero-filled) segment
+        sequences.fill(0);
+        layout->version = SharedControl::kVersion;
+        std::atomic_thread_fence(std::memory_order_release);
+        layout->magic = SharedControl::kMagic;
+    }
+
+    beat();
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+void SharedControlWriter::close()
+{
+    if (layout == nullptr)
+        return;
+
+    // Stale straight away, so mapped readers hand the devices back at their
+    // next check rather than after the timeout
+    layout->heartbeat.store(juce::Time::getMillisecondCounter() - SharedControl::kHeartbeatTimeoutMs, std::memory_order_relaxed);
+
+   #if VMS_SHARED_CONTROL
+    munmap(layout, sizeof(SharedControl::Layout));
+
+    // Existing mappings stay valid; the next daemon starts a fresh segment
+    shm_unlink(SharedControl::kSegmentName);
+   #endif
+
+    layout = nullptr;
+}
+
+void SharedControlWriter::publish(int parameterIndex, float normalisedValue)
+{
+    if (layout == nullptr || ! juce::isPositiveAndBelow(parameterIndex, SharedControl::kNumSlots))
+        return;
+
+    // Never 0, which means "never written"
+    auto& sequence = sequences[(size_t) parameterIndex];
+    sequence = sequence == 0xffffffffu ? 1 : sequence + 1;
+
+    juce::uint32 bits;
+    std::memcpy(&bits, &normalisedValue, sizeof(bits));
+    layout->slots[(size_t) parameterIndex].store(((juce::uint64) sequence << 32) | bits, std::memory_order_release);
+}
+
+void SharedControlWriter::beat()
+{
+    if (layout != nullptr)
+        layout->heartbeat.store(juce::Time::getMillisecondCounter(), std::memory_order_relaxed);
+}
@@ -0,0 +1,162 @@
+/*
+  ==============================================================================
+
+    SharedControlChannel.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "ParameterBridge.h"
+
+// Control values published by an external daemon that owns the MIDI
+// hardware, so plugin instances never open devices themselves.
+//
+// The daemon writes a POSIX shared-memory segment: one slot per parameter
+// index holding the value and a sequence number in one 64-bit atomic, plus
+// a heartbeat time. Readers map it read-only and compare sequence
+// numbers, so reading is a handful of atomic loads and nothing the daemon
+// does (including crashing) can block or corrupt the audio thread; values
+// simply stop changing.
+//
+// The daemon counts as running only while its heartbeat is fresh, not
+// merely because the segment exists: one that crashed leaves the segment
+// behind with a stale heartbeat. A clean shutdown unlinks the segment.
+//
+// Slots are indexed like ParameterBridge (gain is 0). Last value wins per
+// parameter, which is all the block-level coalescing keeps anyway.
+//
+// Only on macOS and Linux; elsewhere the segment never exists.
+namespace SharedControl
+{
+    constexpr const char* kSegmentName = "/vms_set_gain_control";
+    constexpr juce::uint32 kMagic = 0x564d5343;    // "VMSC"
+    constexpr juce::uint32 kVersion = 2;
+    constexpr int kNumSlots = ParameterBridge::kMaxParameters;
+
+    // A heartbeat older than this means the daemon is gone
+    constexpr juce::uint32 kHeartbeatTimeoutMs = 2000;
+
+    struct Layout
+    {
+        juce::uint32 magic;
+        juce::uint32 version;
+        std::atomic<juce::uint32> heartbeat;            // getMillisecondCounter() of the last beat, a few times a second
+        std::array<std::atomic<juce::uint64>, kNumSlots> slots; // sequence << 32 | float bits; 0 = never written
+    };
+
+    static_assert(std::atomic<juce::uint64>::is_always_lock_free, "slots must be lock-free to be shared between processes");
+
+    // The millisecond counter is system-wide (monotonic since boot), so
+    // it can be compared across processes
+    inline bool isAlive(const Layout& layout)
+    {
+        return juce::Time::getMillisecondCounter() - layout.heartbeat.load(std::memory_order_relaxed) < kHeartbeatTimeoutMs;
+    }
+}
+
+//==============================================================================
+// Plugin side. Maps the segment when it appears (checked once a second on
+// the message thread) and follows a daemon that restarts with a new one.
+// A change message goes out on the message thread when the daemon comes
+// or goes.
+class SharedControlReader : public juce::ChangeBroadcaster,
+                            private juce::Timer
+{
+public:
+    //==============================================================================
+    SharedControlReader();
+    ~SharedControlReader() override;
+
+    // Audio thread, wait-free: calls fn(parameterIndex, normalisedValue) for
+    // every slot the daemon wrote since the last call
+    template <typename Function>
+    void forEachChange(Function&& fn)
+    {
+        const auto* layout = current.load(std::memory_order_acquire);
+        if (layout == nullptr)
+            return;
+
+        // A new segment: everything in it is new
+        if (layout != lastLayout)
+        {
+            lastSequences.fill(0);
+            lastLayout = layout;
+        }
+
+        for (size_t i = 0; i < (size_t) SharedControl::kNumSlots; ++i)
+        {
+            const auto packed = layout->slots[i].load(std::memory_order_acquire);
+            const auto sequence = (juce::uint32) (packed >> 32);
+
+            if (sequence == lastSequences[i])
+                continue;
+
+            lastSequences[i] = sequence;
+
+            const auto bits = (juce::uint32) packed;
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+
+            if (std::isfinite(value))
+                fn((int) i, juce::jlimit(0.0f, 1.0f, value));
+        }
+    }
+
+    // Any thread: mapped and the heartbeat is fresh
+    bool isConnected() const { return connected.load(std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    struct Mapping
+    {
+        void* address = nullptr;
+        size_t size = 0;
+        juce::uint64 inode = 0;
+    };
+
+    void timerCallback() override;
+    bool map();
+    void setConnected(bool isNowConnected);
+
+    std::atomic<const SharedControl::Layout*> current { nullptr };
+    std::atomic<bool> connected { false };
+
+    // Message thread. Replaced mappings stay mapped until destruction, as the
+    // audio thread may still be reading them.
+    juce::Array<Mapping> mappings;
+
+    // Audio thread only
+    const SharedControl::Layout* lastLayout = nullptr;
+    std::array<juce::uint32, SharedControl::kNumSlots> lastSequences {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedControlReader)
+};
+
+//==============================================================================
+// Daemon side: creates (or reopens) the segment and publishes into it.
+// Single writer; call beat() regularly so readers can tell it's alive.
+// close() (or destruction) is the clean shutdown: readers let go at their
+// next check and the segment is unlinked.
+class SharedControlWriter
+{
+public:
+    //==============================================================================
+    SharedControlWriter() = default;
+    ~SharedControlWriter();
+
+    bool open();
+    void close();
+
+    void publish(int parameterIndex, float normalisedValue);
+    void beat();
+
+private:
+    //==============================================================================
+    SharedControl::Layout* layout = nullptr;
+    std::array<juce::uint32, SharedControl::kNumSlots> sequences {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SharedControlWriter)
+};
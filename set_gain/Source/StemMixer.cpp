@@ -0,0 +1,88 @@
+/*
+  ==============================================================================
+
+    StemMixer.cpp
+
+  ==============================================================================
+*/
+
+#include "StemMixer.h"
+
+//==============================================================================
+void StemMixer::prepareToPlay(double sampleRate)
+{
+    for (auto& g : gains)
+        g.reset(sampleRate, 0.02);
+}
+
+void StemMixer::setBusGain(int bus, float gain, bool muted)
+{
+    gains[(size_t) bus].setTargetValue(muted ? 0.0f : gain);
+}
+
+void StemMixer::process(juce::AudioBuffer<float>& buffer, int numOutputChannels,
+                        const std::array<BusChannels, kMaxBuses>& buses)
+{
+    const int numSamples = buffer.getNumSamples();
+
+    // Per-block linear ramp for every bus that contributes anything;
+    // muted or disabled buses are dropped here and never read
+    int activeBus[kMaxBuses];
+    float startGain[kMaxBuses], gainStep[kMaxBuses];
+    int numActive = 0;
+    bool unityMainOnly = true;
+
+    for (int bus = 0; bus < kMaxBuses; ++bus)
+    {
+        auto& g = gains[(size_t) bus];
+        const float from = g.getCurrentValue();
+        const float to = g.skip(numSamples);
+
+        if (buses[(size_t) bus].numChannels == 0 || (from == 0.0f && to == 0.0f))
+            continue;
+
+        activeBus[numActive] = bus;
+        startGain[numActive] = from;
+        gainStep[numActive] = (to - from) / (float) numSamples;
+        ++numActive;
+
+        if (bus != 0 || from != 1.0f || to != 1.0f)
+            unityMainOnly = false;
+    }
+
+    // Plain insert use: the main input is already in place
+    if (unityMainOnly && numActive == 1)
+        return;
+
+    for (int ch = 0; ch < numOutputChannels; ++ch)
+    {
+        // Mono buses feed every output channel
+        const float* source[kMaxBuses];
+        for (int k = 0; k < numActive; ++k)
+        {
+            const auto& bus = buses[(size_t) activeBus[k]];
+            source[k] = buffer.getReadPointer(bus.firstChannel + juce::jmin(ch, bus.numChannels - 1));
+        }
+
+        auto* out = buffer.getWritePointer(ch);
+
+        for (int start = 0; start < numSamples; start += kChunkSize)
+        {
+            const int length = juce::jmin(kChunkSize, numSamples - start);
+            float acc[kChunkSize] = {};
+
+            for (int k = 0; k < numActive; ++k)
+            {
+                const float* in = source[k] + start;
+                const float g0 = startGain[k] + gainStep[k] * (float) (start + 1);
+                const float step = gainStep[k];
+
+                for (int i = 0; i < length; ++i)
+                    acc[i] += in[i] * (g0 + step * (float) i);
+            }
+
+            // Safe for the main bus too: its chunk has been fully read above
+            std::copy(acc, acc + length, out + start);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+/*
+  ==============================================================================
+
+    StemMixer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+// Sums up to kMaxBuses input buses into the main output, each with its own
+// smoothed gain and mute. Every output channel is written once: the active
+// buses are accumulated into a small stack chunk that stays in L1, so the
+// inner loops are plain multiply-adds the compiler can vectorise.
+class StemMixer
+{
+public:
+    //==============================================================================
+    static constexpr int kMaxBuses = 8;
+
+    // Where an input bus lives in the processBlock buffer. numChannels is 0
+    // for a disabled bus.
+    struct BusChannels
+    {
+        int firstChannel = 0;
+        int numChannels = 0;
+    };
+
+    //==============================================================================
+    StemMixer() = default;
+
+    // Call this in the plugin's prepareToPlay method
+    void prepareToPlay(double sampleRate);
+
+    // Audio thread, once per block before process()
+    void setBusGain(int bus, float gain, bool muted);
+
+    // Mixes the input buses into the first numOutputChannels channels of buffer
+    void process(juce::AudioBuffer<float>& buffer, int numOutputChannels,
+                 const std::array<BusChannels, kMaxBuses>& buses);
+
+private:
+    //==============================================================================
+    static constexpr int kChunkSize = 64;
+
+    std::array<juce::SmoothedValue<float>, kMaxBuses> gains;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(StemMixer)
+};
@@ -0,0 +1,114 @@
+/*
+  ==============================================================================
+
+    UmpControllerDecoder.cpp
+
+  ==============================================================================
+*/
+
+#include "UmpControllerDecoder.h"
+
+//==============================================================================
+namespace
+{
+    constexpr juce::uint32 kMidi1ChannelVoice = 0x2;
+    constexpr juce::uint32 kMidi2ChannelVoice = 0x4;
+
+    // MIDI 2.0 channel voice status nibbles
+    constexpr juce::uint32 kRegisteredPerNote = 0x0;
+    constexpr juce::uint32 kAssignablePerNote = 0x1;
+    constexpr juce::uint32 kRegistered = 0x2;
+    constexpr juce::uint32 kAssignable = 0x3;
+    constexpr juce::uint32 kControlChange = 0xb;
+
+    // 14-bit -> 32-bit, so that 0 and kMaxValue land on the ends of the range
+    juce::uint32 widen14Bit(int value)
+    {
+        return (juce::uint32) (((juce::uint64) value * 0xffffffffu + HighResControllerParser::kMaxValue / 2)
+                               / HighResControllerParser::kMaxValue);
+    }
+}
+
+//==============================================================================
+int UmpControllerDecoder::getNumWords(juce::uint32 firstWord)
+{
+    return (int) juce::universal_midi_packets::Utils::getNumWordsForMessageType(firstWord);
+}
+
+bool UmpControllerDecoder::process(const juce::uint32* words, Event& event)
+{
+    switch (words[0] >> 28)
+    {
+        case kMidi2ChannelVoice:    return processMidi2(words, event);
+        case kMidi1ChannelVoice:    return processMidi1(words[0], event);
+        default:                    return false;
+    }
+}
+
+bool UmpControllerDecoder::fromBytestream(const juce::MidiMessage& message, juce::uint32& word)
+{
+    const auto* data = message.getRawData();
+    const int size = message.getRawDataSize();
+
+    if (size < 2 || size > 3 || data[0] < 0x80 || data[0] >= 0xf0)
+        return false;
+
+    word = (kMidi1ChannelVoice << 28) | ((juce::uint32) data[0] << 16) | ((juce::uint32) data[1] << 8)
+         | (size > 2 ? (juce::uint32) data[2] : 0u);
+    return true;
+}
+
+//==============================================================================
+bool UmpControllerDecoder::processMidi2(const juce::uint32* words, Event& event)
+{
+    const auto status = (words[0] >> 20) & 0xf;
+    const auto byte3 = (int) ((words[0] >> 8) & 0x7f);
+    const auto byte4 = (int) (words[0] & 0x7f);
+
+    event.channel = (int) ((words[0] >> 16) & 0xf) + 1;
+    event.value = words[1];
+
+    switch (status)
+    {
+        case kControlChange:
+            event.type = Type::controller;
+            event.number = byte3;
+            return true;
+
+        case kRegistered:
+        case kAssignable:
+            // Bank and index are the MSB and LSB of the MIDI 1.0 parameter number
+            event.type = status == kRegistered ? Type::rpn : Type::nrpn;
+            event.number = (byte3 << 7) | byte4;
+            return true;
+
+        case kRegisteredPerNote:
+        case kAssignablePerNote:
+            // byte3 is the note, which the gain doesn't care about
+            event.type = Type::controller;
+            event.number = (int) (words[0] & 0xff);
+            return event.number < 128;
+
+        default:
+            return false;
+    }
+}
+
+bool UmpControllerDecoder::processMidi1(juce::uint32 word, Event& event)
+{
+    const auto statusByte = (word >> 16) & 0xff;
+
+    if ((statusByte & 0xf0) != 0xb0)
+        return false;
+
+    HighResControllerParser::Event midi1Event;
+
+    if (! midi1Parser.process((int) (statusByte & 0xf) + 1, (int) ((word >> 8) & 0x7f), (int) (word & 0x7f), midi1Event))
+        return false;
+
+    event.type = midi1Event.type;
+    event.channel = midi1Event.channel;
+    event.number = midi1Event.number;
+    event.value = widen14Bit(midi1Event.value);
+    return true;
+}
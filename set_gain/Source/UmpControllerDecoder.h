@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    UmpControllerDecoder.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "HighResControllerParser.h"
+
+// Decodes Universal MIDI Packets into controller events with the full
+// 32-bit MIDI 2.0 resolution, one packet at a time and without allocating.
+//
+//  - MIDI 2.0 channel voice (type 4): CC, registered/assignable controllers
+//    (RPN/NRPN) and per-note controllers, whose index is treated as a CC
+//    number since a gain has no per-note state. Relative controllers are
+//    ignored.
+//  - MIDI 1.0 channel voice (type 2): translated through a
+//    HighResControllerParser, so 14-bit pairs and NRPN sequences still work,
+//    then widened to 32 bits.
+//
+// Groups are folded onto the 16 channels. One instance must only be fed
+// from one thread.
+class UmpControllerDecoder
+{
+public:
+    //==============================================================================
+    using Type = HighResControllerParser::Type;
+
+    struct Event
+    {
+        Type type = Type::controller;
+        int channel = 1;            // 1-16
+        int number = 0;             // CC number, or the 14-bit NRPN/RPN number
+        juce::uint32 value = 0;     // full 32-bit range
+
+        float getNormalised() const { return (float) ((double) value / (double) 0xffffffffu); }
+    };
+
+    //==============================================================================
+    UmpControllerDecoder() = default;
+
+    void reset() { midi1Parser.reset(); }
+
+    // Number of 32-bit words in the packet starting with this word
+    static int getNumWords(juce::uint32 firstWord);
+
+    // words must hold getNumWords(words[0]) words. Returns true if the
+    // packet produced an event.
+    bool process(const juce::uint32* words, Event& event);
+    
+    // A byte-stream channel voice message as the MIDI 1.0 packet (type 2,
+    // group 1) a UMP transport carries it in. False for anything else.
+    static bool fromBytestream(const juce::MidiMessage& message, juce::uint32& word);
+
+private:
+    //==============================================================================
+    bool processMidi2(const juce::uint32* words, Event& event);
+    bool processMidi1(juce::uint32 word, Event& event);
+
+    HighResControllerParser midi1Parser;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(UmpControllerDecoder)
+};
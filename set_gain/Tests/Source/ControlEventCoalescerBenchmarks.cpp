@@ -0,0 +1,238 @@
+/*
+  ==============================================================================
+
+    ControlEventCoalescerBenchmarks.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/ControlEventCoalescer.h"
+#include "../../Source/HighResControllerParser.h"
+#include "../../Source/ParameterBridge.h"
+
+//==============================================================================
+// A controller streaming 1000 CC messages a second (14-bit CC 7/39 pairs, so
+// 500 gain values a second) into a gain parameter with an APVTS listener
+// attached, as the editor's attachment would be. Two control paths:
+//
+//   per event   every value goes to setValueNotifyingHost on the audio thread,
+//               and the gain ramp is split at every event (the path before
+//               coalescing)
+//   coalesced   one change per block through ControlEventCoalescer into the
+//               ParameterBridge, which publishes to the host and listeners
+//               at its update rate, as its timer would
+//
+// Audio thread time includes the notifications of the per-event path; the
+// notification time is also reported on its own for both. Run with the
+// "Benchmarks" category.
+class ControlEventCoalescerBenchmarks : public juce::UnitTest
+{
+public:
+    ControlEventCoalescerBenchmarks() : juce::UnitTest("Control event coalescing, 1 kHz CC storm", "Benchmarks") {}
+
+    void runTest() override
+    {
+        for (const int blockSize : { 64, 512, 2048 })
+        {
+            beginTest(juce::String(blockSize) + " samples per block at 48 kHz");
+
+            const auto perEvent = run(blockSize, false);
+            const auto coalesced = run(blockSize, true);
+
+            logMessage("messages/block " + juce::String(perEvent.messagesPerBlock, 2)
+                       + "   gain updates/block " + juce::String(perEvent.updatesPerBlock, 2)
+                       + " -> " + juce::String(coalesced.updatesPerBlock, 2));
+            logMessage("notifications/s " + juce::String(perEvent.notificationsPerSecond, 1)
+                       + " -> " + juce::String(coalesced.notificationsPerSecond, 1));
+            logMessage("us/block audio thread per event " + juce::String(perEvent.microsPerBlock, 3)
+                       + "   coalesced " + juce::String(coalesced.microsPerBlock, 3)
+                       + "   x" + juce::String(perEvent.microsPerBlock / coalesced.microsPerBlock, 2));
+            logMessage("us/s notifying per event " + juce::String(perEvent.notifyMicrosPerSecond, 1)
+                       + "   coalesced " + juce::String(coalesced.notifyMicrosPerSecond, 1));
+
+            expectLessOrEqual(coalesced.updatesPerBlock, 1.0);
+            expectLessOrEqual(coalesced.notificationsPerSecond, (double) ParameterBridge::kDefaultHostUpdateRateHz + 1.0);
+            expect(std::isfinite(checksum));
+        }
+    }
+
+private:
+    static constexpr double kSampleRate = 48000.0;
+    static constexpr double kMessagesPerSecond = 1000.0;
+    static constexpr double kSeconds = 20.0;
+    static constexpr int kNumChannels = 2;
+
+    struct Result
+    {
+        double messagesPerBlock = 0.0, updatesPerBlock = 0.0, microsPerBlock = 0.0;
+        double notificationsPerSecond = 0.0, notifyMicrosPerSecond = 0.0;
+    };
+
+    //==============================================================================
+    // Just enough of a plugin to own the parameter and the bridge
+    class GainProcessor : public juce::AudioProcessor
+    {
+    public:
+        GainProcessor()
+            : parameters(*this, nullptr, "PARAMETERS",
+                         { std::make_unique<juce::AudioParameterFloat>("gain", "Gain", 0.0f, 1.0f, 0.5f) })
+        {
+        }
+
+        const juce::String getName() const override { return "Benchmark"; }
+        void prepareToPlay(double, int) override {}
+        void releaseResources() override {}
+        void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+        double getTailLengthSeconds() const override { return 0.0; }
+        bool acceptsMidi() const override { return true; }
+        bool producesMidi() const override { return false; }
+        juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+        bool hasEditor() const override { return false; }
+        int getNumPrograms() override { return 1; }
+        int getCurrentProgram() override { return 0; }
+        void setCurrentProgram(int) override {}
+        const juce::String getProgramName(int) override { return {}; }
+        void changeProgramName(int, const juce::String&) override {}
+        void getStateInformation(juce::MemoryBlock&) override {}
+        void setStateInformation(const void*, int) override {}
+
+        juce::AudioProcessorValueTreeState parameters;
+        ParameterBridge bridge { *this };
+    };
+
+    // Stands in for the editor's slider attachment
+    struct CountingListener : public juce::AudioProcessorValueTreeState::Listener
+    {
+        void parameterChanged(const juce::String&, float newValue) override
+        {
+            ++count;
+            last = newValue;
+        }
+
+        int count = 0;
+        float last = 0.0f;
+    };
+
+    Result run(int blockSize, bool coalesce)
+    {
+        GainProcessor processor;
+        CountingListener listener;
+        processor.parameters.addParameterListener("gain", &listener);
+
+        auto* parameter = processor.parameters.getParameter("gain");
+        const int gainIndex = parameter->getParameterIndex();
+
+        HighResControllerParser parser;
+        ControlEventCoalescer coalescer;
+        juce::SmoothedValue<float> gain;
+        gain.reset(kSampleRate, 0.02);
+        gain.setCurrentAndTargetValue(0.5f);
+
+        juce::AudioBuffer<float> audio(kNumChannels, blockSize);
+        const int numBlocks = (int) (kSeconds * kSampleRate / blockSize);
+        const double samplesPerMessage = kSampleRate / kMessagesPerSecond;
+        const double samplesPerPublish = kSampleRate / processor.bridge.getHostUpdateRate();
+
+        juce::int64 messages = 0, updates = 0, ticks = 0, notifyTicks = 0;
+        double nextMessage = 0.0, nextPublish = 0.0;
+        int value = 0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            const juce::int64 blockStart = (juce::int64) block * blockSize;
+            const auto start = juce::Time::getHighResolutionTicks();
+            juce::int64 blockNotifyTicks = 0;
+            int applied = 0;
+
+            if (coalesce)
+                coalescer.clear();
+
+            for (; nextMessage < (double) (blockStart + blockSize); nextMessage += samplesPerMessage, ++messages)
+            {
+                const int position = (int) (nextMessage - (double) blockStart);
+                const bool isMsb = messages % 2 == 0;
+                if (isMsb)
+                    value = (value + 37) & 0x3fff;
+
+                HighResControllerParser::Event event;
+                if (! parser.process(1, isMsb ? 7 : 39, isMsb ? value >> 7 : value & 0x7f, event))
+                    continue;
+
+                if (coalesce)
+                {
+                    coalescer.add(gainIndex, event.getNormalised(), position);
+                    continue;
+                }
+
+                // Host and listeners hear about every value, from the audio thread
+                const auto notifyStart = juce::Time::getHighResolutionTicks();
+                parameter->setValueNotifyingHost(event.getNormalised());
+                blockNotifyTicks += juce::Time::getHighResolutionTicks() - notifyStart;
+
+                applyGain(audio, gain, applied, position);
+                gain.setTargetValue(event.getNormalised());
+                applied = position;
+                ++updates;
+            }
+
+            if (coalesce)
+            {
+                if (const auto* change = coalescer.findChange(gainIndex))
+                {
+                    processor.bridge.push(gainIndex, change->normalisedValue);
+                    applyGain(audio, gain, 0, change->samplePosition);
+                    gain.setTargetValue(processor.bridge.getDspValue(gainIndex));
+                    applied = change->samplePosition;
+                    ++updates;
+                }
+            }
+
+            applyGain(audio, gain, applied, blockSize);
+            ticks += juce::Time::getHighResolutionTicks() - start;
+            notifyTicks += blockNotifyTicks;
+            checksum += (double) audio.getReadPointer(0)[blockSize - 1];
+
+            // The bridge's timer, on the message thread in the plugin
+            for (; coalesce && nextPublish < (double) (blockStart + blockSize); nextPublish += samplesPerPublish)
+            {
+                const auto publishStart = juce::Time::getHighResolutionTicks();
+                processor.bridge.publishPending();
+                notifyTicks += juce::Time::getHighResolutionTicks() - publishStart;
+            }
+        }
+
+        processor.parameters.removeParameterListener("gain", &listener);
+        checksum += (double) listener.last;
+
+        Result result;
+        result.messagesPerBlock = (double) messages / numBlocks;
+        result.updatesPerBlock = (double) updates / numBlocks;
+        result.microsPerBlock = juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6 / numBlocks;
+        result.notificationsPerSecond = listener.count / kSeconds;
+        result.notifyMicrosPerSecond = juce::Time::highResolutionTicksToSeconds(notifyTicks) * 1.0e6 / kSeconds;
+        return result;
+    }
+
+    // Per-sample smoothed gain over [from, to), as processBlock applies it
+    static void applyGain(juce::AudioBuffer<float>& audio, juce::SmoothedValue<float>& gain, int from, int to)
+    {
+        constexpr int kChunkSize = 64;
+
+        for (int start = from; start < to; start += kChunkSize)
+        {
+            const int count = juce::jmin(kChunkSize, to - start);
+            float gains[kChunkSize];
+
+            for (int i = 0; i < count; ++i)
+                gains[i] = gain.getNextValue();
+
+            for (int channel = 0; channel < audio.getNumChannels(); ++channel)
+                juce::FloatVectorOperations::multiply(audio.getWritePointer(channel, start), gains, count);
+        }
+    }
+
+    double checksum = 0.0;
+};
+
+static ControlEventCoalescerBenchmarks controlEventCoalescerBenchmarks;
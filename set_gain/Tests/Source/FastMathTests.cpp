@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    FastMathTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/FastMath.h"
+
+//==============================================================================
+namespace
+{
+    enum class ErrorKind { relative, absolute, absoluteBelowOne };
+
+    // Largest error of an approximation over [start, end] against the long
+    // double reference. Log-spaced sweeps cover ranges spanning many octaves.
+    template <typename T, typename Approximation, typename Reference>
+    double sweep(Approximation approximation, Reference reference, double start, double end,
+                 ErrorKind kind, bool logSpaced = false, int numPoints = 1000000)
+    {
+        double worst = 0.0;
+
+        for (int i = 0; i <= numPoints; ++i)
+        {
+            const double position = (double) i / numPoints;
+            const T x = (T) (logSpaced ? start * std::pow(end / start, position)
+                                       : start + (end - start) * position);
+
+            const long double expected = reference((long double) x);
+            const long double actual = (long double) approximation(x);
+            const long double error = std::abs(actual - expected);
+            const long double magnitude = std::abs(expected);
+
+            double e = (double) error;
+            if (kind == ErrorKind::relative)
+                e = (double) (error / magnitude);
+            else if (kind == ErrorKind::absoluteBelowOne && magnitude > 1.0L)
+                e = (double) (error / magnitude);
+
+            worst = std::max(worst, e);
+        }
+
+        return worst;
+    }
+
+    long double referenceExp2(long double x)     { return std::exp2(x); }
+    long double referenceExp(long double x)      { return std::exp(x); }
+    long double referenceLog2(long double x)     { return std::log2(x); }
+    long double referenceLog(long double x)      { return std::log(x); }
+    long double referenceDbToGain(long double x) { return std::pow(10.0L, x / 20.0L); }
+    long double referenceGainToDb(long double x) { return 20.0L * std::log10(x); }
+    long double referenceTanh(long double x)     { return std::tanh(x); }
+    long double referenceTan(long double x)      { return std::tan(x); }
+}
+
+//==============================================================================
+// Reproduces the error table at the top of FastMath.h. The bounds checked
+// here are the table's, so a change to the approximations that makes them
+// worse fails instead of quietly invalidating the documentation.
+class FastMathAccuracyTests : public juce::UnitTest
+{
+public:
+    FastMathAccuracyTests() : juce::UnitTest("FastMath accuracy", "DSP") {}
+
+    void runTest() override
+    {
+        runFor<float>("float",   { 2.5e-7, 6.7e-7, 4.0e-6, 2.1e-7, 9.5e-7, 3.2e-7, 1.7e-7, 7.3e-7 });
+        runFor<double>("double", { 4.1e-16, 1.1e-15, 5.0e-14, 7.1e-16, 2.4e-15, 1.4e-15, 2.6e-16, 1.1e-15 });
+
+        beginTest("Out of domain inputs are clamped");
+        expect(std::isfinite(fastmath::exp2(1000.0f)) && fastmath::exp2(1000.0f) > 1.0e38f);
+        expect(fastmath::exp2(-1000.0f) > 0.0f && fastmath::exp2(-1000.0f) < 1.0e-37f);
+        expect(std::isfinite(fastmath::log2(0.0f)) && std::isfinite(fastmath::log2(-1.0f)));
+        expectEquals(fastmath::tanh(1.0e6f), 1.0f);
+        expectEquals(fastmath::tanh(-1.0e6f), -1.0f);
+    }
+
+private:
+    struct Bounds
+    {
+        double exp2, expNear, expWhole, log2, dbToGain, gainToDb, tanh, tan;
+    };
+
+    template <typename T>
+    void runFor(const juce::String& typeName, Bounds bounds)
+    {
+        constexpr bool isFloat = std::is_same_v<T, float>;
+        const double minExponent = isFloat ? -126.0 : -1022.0;
+        const double maxExponent = isFloat ? 127.0 : 1023.0;
+        const double smallestNormal = (double) std::numeric_limits<T>::min();
+        const double largest = (double) std::numeric_limits<T>::max();
+
+        // x such that x * log2(e) stays inside exp2's unclamped range
+        const double expMin = (minExponent + 1.0) * std::log(2.0), expMax = maxExponent * std::log(2.0);
+
+        check(typeName, "exp2, whole normal range",
+              sweep<T>([](T x) { return fastmath::exp2(x); }, referenceExp2, minExponent, maxExponent, ErrorKind::relative),
+              bounds.exp2);
+
+        check(typeName, "exp, |x| <= 10",
+              sweep<T>([](T x) { return fastmath::exp(x); }, referenceExp, -10.0, 10.0, ErrorKind::relative),
+              bounds.expNear);
+
+        check(typeName, "exp, whole normal range",
+              sweep<T>([](T x) { return fastmath::exp(x); }, referenceExp, expMin, expMax, ErrorKind::relative),
+              bounds.expWhole);
+
+        check(typeName, "log2, x > 0",
+              sweep<T>([](T x) { return fastmath::log2(x); }, referenceLog2, smallestNormal, largest,
+                       ErrorKind::absoluteBelowOne, true),
+              bounds.log2);
+
+        check(typeName, "log, x > 0",
+              sweep<T>([](T x) { return fastmath::log(x); }, referenceLog, smallestNormal, largest,
+                       ErrorKind::absoluteBelowOne, true),
+              bounds.log2);
+
+        check(typeName, "dbToGain, -150 dB ... +150 dB",
+              sweep<T>([](T x) { return fastmath::dbToGain(x); }, referenceDbToGain, -150.0, 150.0, ErrorKind::relative),
+              bounds.dbToGain);
+
+        check(typeName, "gainToDb, gain > 0",
+              sweep<T>([](T x) { return fastmath::gainToDb(x); }, referenceGainToDb, smallestNormal, largest,
+                       ErrorKind::absoluteBelowOne, true),
+              bounds.gainToDb);
+
+        // tanh is within an ulp of +-1 well before |x| = 20
+        check(typeName, "tanh, all x",
+              sweep<T>([](T x) { return fastmath::tanh(x); }, referenceTanh, -20.0, 20.0, ErrorKind::absolute),
+              bounds.tanh);
+
+        check(typeName, "tan, |x| <= 1.5",
+              sweep<T>([](T x) { return fastmath::tan(x); }, referenceTan, -1.5, 1.5, ErrorKind::relative),
+              bounds.tan);
+    }
+
+    void check(const juce::String& typeName, const juce::String& name, double error, double bound)
+    {
+        beginTest(typeName + " " + name);
+        logMessage("max error " + juce::String(error, 2, true) + ", documented " + juce::String(bound, 2, true));
+        expectLessOrEqual(error, bound, name);
+    }
+};
+
+static FastMathAccuracyTests fastMathAccuracyTests;
+
+//==============================================================================
+// Throughput against std:: over a block, the way the DSP code calls it. Only
+// meaningful in a Release build; run with the "Benchmarks" category.
+class FastMathBenchmarks : public juce::UnitTest
+{
+public:
+    FastMathBenchmarks() : juce::UnitTest("FastMath throughput", "Benchmarks") {}
+
+    void runTest() override
+    {
+        runFor<float>("float");
+        runFor<double>("double");
+    }
+
+private:
+    static constexpr int kBlockSize = 512;
+    static constexpr int kNumBlocks = 20000;
+
+    template <typename T>
+    void runFor(const juce::String& typeName)
+    {
+        beginTest(typeName + ": fastmath vs std, ns per value");
+
+        std::vector<T> input((size_t) kBlockSize), output((size_t) kBlockSize);
+
+        compare<T>("exp2", input, output, -20.0, 20.0,
+                   [](T x) { return fastmath::exp2(x); }, [](T x) { return std::exp2(x); });
+        compare<T>("log2", input, output, 1.0e-6, 1.0e6,
+                   [](T x) { return fastmath::log2(x); }, [](T x) { return std::log2(x); });
+        compare<T>("dbToGain", input, output, -100.0, 20.0,
+                   [](T x) { return fastmath::dbToGain(x); }, [](T x) { return std::pow((T) 10, x * (T) 0.05); });
+        compare<T>("gainToDb", input, output, 1.0e-5, 10.0,
+                   [](T x) { return fastmath::gainToDb(x); }, [](T x) { return (T) 20 * std::log10(x); });
+        compare<T>("tanh", input, output, -5.0, 5.0,
+                   [](T x) { return fastmath::tanh(x); }, [](T x) { return std::tanh(x); });
+        compare<T>("tan", input, output, 0.0, 1.5,
+                   [](T x) { return fastmath::tan(x); }, [](T x) { return std::tan(x); });
+    }
+
+    template <typename T, typename Fast, typename Reference>
+    void compare(const juce::String& name, std::vector<T>& input, std::vector<T>& output,
+                 double low, double high, Fast fast, Reference reference)
+    {
+        auto random = getRandom();
+        for (auto& x : input)
+            x = (T) (low + (high - low) * random.nextDouble());
+
+        const double fastNs = timePerValue(input, output, fast);
+        const double referenceNs = timePerValue(input, output, reference);
+
+        logMessage(name.paddedRight(' ', 10) + "fastmath " + juce::String(fastNs, 2) + "   std " + juce::String(referenceNs, 2)
+                   + "   x" + juce::String(referenceNs / fastNs, 1));
+        expect(std::isfinite(checksum));
+    }
+
+    template <typename T, typename Function>
+    double timePerValue(const std::vector<T>& input, std::vector<T>& output, Function function)
+    {
+        const auto start = juce::Time::getHighResolutionTicks();
+
+        for (int block = 0; block < kNumBlocks; ++block)
+        {
+            for (int i = 0; i < kBlockSize; ++i)
+                output[(size_t) i] = function(input[(size_t) i]);
+
+            // Keeps the loop from being optimised away
+            checksum += (double) output[(size_t) (block % kBlockSize)];
+        }
+
+        const auto seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        return seconds * 1.0e9 / ((double) kBlockSize * kNumBlocks);
+    }
+
+    double checksum = 0.0;
+};
+
+static FastMathBenchmarks fastMathBenchmarks;
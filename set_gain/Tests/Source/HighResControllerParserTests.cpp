@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    HighResControllerParserTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/HighResControllerParser.h"
+
+//==============================================================================
+// Feeds the parser the message orders real controllers produce, including
+// streams interleaved across channels and with plain CCs, and sequences
+// that stop halfway.
+class HighResControllerParserTests : public juce::UnitTest
+{
+public:
+    HighResControllerParserTests() : juce::UnitTest("HighResControllerParser", "MIDI") {}
+
+    void runTest() override
+    {
+        using Type = HighResControllerParser::Type;
+
+        beginTest("7-bit controllers reach the full range");
+        {
+            HighResControllerParser parser;
+            expectEvent(parser, 1, 7, 0, Type::controller, 7, 0);
+            expectEvent(parser, 1, 7, 127, Type::controller, 7, HighResControllerParser::kMaxValue);
+            expectEvent(parser, 1, 74, 127, Type::controller, 74, HighResControllerParser::kMaxValue);
+        }
+
+        beginTest("14-bit controller, MSB then LSB");
+        {
+            HighResControllerParser parser;
+            expectEvent(parser, 1, 7, 100, Type::controller, 7, scaled(100));
+            expectEvent(parser, 1, 39, 5, Type::controller, 7, (100 << 7) | 5);
+
+            // Once the LSB has been seen a new MSB is taken as the top 7 bits
+            expectEvent(parser, 1, 7, 101, Type::controller, 7, 101 << 7);
+            expectEvent(parser, 1, 39, 127, Type::controller, 7, (101 << 7) | 127);
+        }
+
+        beginTest("14-bit controllers interleaved across numbers and channels");
+        {
+            HighResControllerParser parser;
+            expectEvent(parser, 1, 7, 10, Type::controller, 7, scaled(10));
+            expectEvent(parser, 1, 1, 20, Type::controller, 1, scaled(20));
+            expectEvent(parser, 2, 7, 30, Type::controller, 7, scaled(30));
+            expectEvent(parser, 1, 39, 1, Type::controller, 7, (10 << 7) | 1);
+            expectEvent(parser, 2, 39, 2, Type::controller, 7, (30 << 7) | 2);
+            expectEvent(parser, 1, 33, 3, Type::controller, 1, (20 << 7) | 3);
+
+            // The LSB seen on channel 1 doesn't make channel 3 14-bit
+            expectEvent(parser, 3, 7, 64, Type::controller, 7, scaled(64));
+        }
+
+        beginTest("NRPN with 14-bit data");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 1, 99, 3);
+            expectNoEvent(parser, 1, 98, 17);
+            expectEvent(parser, 1, 6, 64, Type::nrpn, (3 << 7) | 17, scaled(64));
+            expectEvent(parser, 1, 38, 9, Type::nrpn, (3 << 7) | 17, (64 << 7) | 9);
+
+            // A new MSB clears the LSB
+            expectEvent(parser, 1, 6, 65, Type::nrpn, (3 << 7) | 17, 65 << 7);
+        }
+
+        beginTest("NRPN on two channels, interleaved message by message");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 1, 99, 1);
+            expectNoEvent(parser, 2, 99, 2);
+            expectNoEvent(parser, 1, 98, 10);
+            expectNoEvent(parser, 2, 98, 20);
+            expectEvent(parser, 2, 6, 40, Type::nrpn, (2 << 7) | 20, scaled(40));
+            expectEvent(parser, 1, 6, 50, Type::nrpn, (1 << 7) | 10, scaled(50));
+            expectEvent(parser, 1, 38, 1, Type::nrpn, (1 << 7) | 10, (50 << 7) | 1);
+            expectEvent(parser, 2, 38, 2, Type::nrpn, (2 << 7) | 20, (40 << 7) | 2);
+        }
+
+        beginTest("NRPN interleaved with plain and 14-bit CCs on the same channel");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 1, 99, 0);
+            expectEvent(parser, 1, 7, 100, Type::controller, 7, scaled(100));
+            expectNoEvent(parser, 1, 98, 5);
+            expectEvent(parser, 1, 39, 3, Type::controller, 7, (100 << 7) | 3);
+            expectEvent(parser, 1, 6, 20, Type::nrpn, 5, scaled(20));
+            expectEvent(parser, 1, 64, 127, Type::controller, 64, HighResControllerParser::kMaxValue);
+            expectEvent(parser, 1, 38, 7, Type::nrpn, 5, (20 << 7) | 7);
+        }
+
+        beginTest("RPN and NRPN selections don't mix");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 1, 101, 0);
+
+            // An NRPN LSB after an RPN MSB starts a new, incomplete NRPN selection
+            expectNoEvent(parser, 1, 98, 2);
+            expectNoEvent(parser, 1, 6, 12);
+
+            expectNoEvent(parser, 1, 101, 0);
+            expectNoEvent(parser, 1, 100, 0);
+            expectEvent(parser, 1, 6, 2, Type::rpn, 0, scaled(2));
+        }
+
+        beginTest("Partial sequences produce nothing");
+        {
+            HighResControllerParser parser;
+
+            // Data entry with nothing selected is an ordinary CC
+            expectEvent(parser, 1, 6, 10, Type::controller, 6, scaled(10));
+            expectEvent(parser, 1, 38, 10, Type::controller, 6, (10 << 7) | 10);
+
+            // Only the MSB of the parameter number
+            expectNoEvent(parser, 1, 99, 4);
+            expectNoEvent(parser, 1, 6, 10);
+            expectNoEvent(parser, 1, 38, 10);
+            expectNoEvent(parser, 1, 96, 0);
+
+            // Data sent before the selection completed is dropped, not applied to it
+            expectNoEvent(parser, 1, 98, 1);
+            expectEvent(parser, 1, 38, 3, Type::nrpn, (4 << 7) | 1, 3);
+        }
+
+        beginTest("Null parameter closes the sequence");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 1, 101, 0);
+            expectNoEvent(parser, 1, 100, 0);
+            expectEvent(parser, 1, 6, 2, Type::rpn, 0, scaled(2));
+
+            expectNoEvent(parser, 1, 101, 127);
+            expectNoEvent(parser, 1, 100, 127);
+            expectEvent(parser, 1, 6, 5, Type::controller, 6, scaled(5));
+        }
+
+        beginTest("Increment and decrement");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 1, 99, 0);
+            expectNoEvent(parser, 1, 98, 1);
+            expectEvent(parser, 1, 6, 10, Type::nrpn, 1, scaled(10));
+
+            // No LSB seen yet: steps of one MSB
+            expectEvent(parser, 1, 96, 0, Type::nrpn, 1, scaled(11));
+            expectEvent(parser, 1, 97, 0, Type::nrpn, 1, scaled(10));
+
+            // After an LSB: steps of one LSB, clamped at the ends
+            expectEvent(parser, 1, 38, 0, Type::nrpn, 1, 10 << 7);
+            expectEvent(parser, 1, 96, 0, Type::nrpn, 1, (10 << 7) + 1);
+            expectEvent(parser, 1, 6, 127, Type::nrpn, 1, 127 << 7);
+            expectEvent(parser, 1, 38, 127, Type::nrpn, 1, HighResControllerParser::kMaxValue);
+            expectEvent(parser, 1, 96, 0, Type::nrpn, 1, HighResControllerParser::kMaxValue);
+        }
+
+        beginTest("Out of range input and non-controller messages are ignored");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 0, 7, 10);
+            expectNoEvent(parser, 17, 7, 10);
+            expectNoEvent(parser, 1, 128, 10);
+            expectNoEvent(parser, 1, 7, 128);
+
+            HighResControllerParser::Event event;
+            expect(! parser.process(juce::MidiMessage::noteOn(1, 60, (juce::uint8) 100), event));
+            expect(parser.process(juce::MidiMessage::controllerEvent(1, 7, 127), event));
+            expectEquals(event.value, HighResControllerParser::kMaxValue);
+        }
+
+        beginTest("reset() forgets selections and LSB pairing");
+        {
+            HighResControllerParser parser;
+            expectNoEvent(parser, 1, 99, 0);
+            expectNoEvent(parser, 1, 98, 1);
+            expectEvent(parser, 1, 39, 1, Type::controller, 7, 1);
+            parser.reset();
+            expectEvent(parser, 1, 6, 10, Type::controller, 6, scaled(10));
+            expectEvent(parser, 1, 7, 10, Type::controller, 7, scaled(10));
+        }
+    }
+
+private:
+    static int scaled(int value7Bit)
+    {
+        return (value7Bit * HighResControllerParser::kMaxValue + 63) / 127;
+    }
+
+    void expectEvent(HighResControllerParser& parser, int channel, int controller, int value,
+                     HighResControllerParser::Type type, int number, int expectedValue)
+    {
+        HighResControllerParser::Event event;
+        const auto what = "ch " + juce::String(channel) + " cc " + juce::String(controller) + " = " + juce::String(value);
+
+        if (! parser.process(channel, controller, value, event))
+        {
+            expect(false, what + ": no event");
+            return;
+        }
+
+        expect(event.type == type, what + ": type");
+        expectEquals(event.channel, channel, what + ": channel");
+        expectEquals(event.number, number, what + ": number");
+        expectEquals(event.value, expectedValue, what + ": value");
+    }
+
+    void expectNoEvent(HighResControllerParser& parser, int channel, int controller, int value)
+    {
+        HighResControllerParser::Event event;
+        expect(! parser.process(channel, controller, value, event),
+               "ch " + juce::String(channel) + " cc " + juce::String(controller) + " = " + juce::String(value) + ": unexpected event");
+    }
+};
+
+static HighResControllerParserTests highResControllerParserTests;
@@ -0,0 +1,46 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// Runs the set_gain unit tests. With no argument every category except
+// "Benchmarks" and "Hotplug" (which needs a system MIDI service) runs; pass
+// a category name to run only that one, e.g.
+//
+//     SetGainTests Benchmarks
+//
+// Returns non-zero if any test failed.
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+
+    juce::UnitTestRunner runner;
+    runner.setAssertOnFailure(false);
+
+    if (argc > 1)
+    {
+        runner.runTestsInCategory(argv[1]);
+    }
+    else
+    {
+        juce::Array<juce::UnitTest*> tests;
+
+        for (auto* test : juce::UnitTest::getAllTests())
+            if (test->getCategory() != "Benchmarks" && test->getCategory() != "Hotplug")
+                tests.add(test);
+
+        runner.runTests(tests);
+    }
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        if (runner.getResult(i)->failures > 0)
+            return 1;
+
+    return 0;
+}
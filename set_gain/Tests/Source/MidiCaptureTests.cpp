@@ -0,0 +1,94 @@
+/*
+  ==============================================================================
+
+    MidiCaptureTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+// Records device and host MIDI to a capture file, reads it back, then plays
+// it offline through a scratch processor and checks the gain it ends on.
+class MidiCaptureTests : public juce::UnitTest
+{
+public:
+    MidiCaptureTests() : juce::UnitTest("MIDI capture record and replay", "MIDI") {}
+
+    void runTest() override
+    {
+        const juce::TemporaryFile capture(".vmsm");
+
+        beginTest("Recorded events read back in order");
+        {
+            MidiCaptureRecorder recorder;
+            expect(recorder.start(capture.getFile()));
+
+            recorder.recordDevice(juce::MidiMessage::controllerEvent(1, 7, 32), 2);
+            juce::Thread::sleep(kGapMs);
+
+            juce::MidiBuffer hostMidi;
+            hostMidi.addEvent(juce::MidiMessage::controllerEvent(1, 7, 96), 17);
+            recorder.recordHost(hostMidi);
+            juce::Thread::sleep(kGapMs);
+
+            recorder.recordDevice(juce::MidiMessage::controllerEvent(1, 7, 127), 2);
+            recorder.stop();
+            expectEquals(recorder.getNumDropped(), 0);
+
+            MidiCaptureReplayer replayer(capture.getFile());
+            expect(replayer.isValid());
+
+            MidiCaptureReplayer::Event first, second, third, none;
+            expect(replayer.readNext(first) && replayer.readNext(second) && replayer.readNext(third));
+            expect(! replayer.readNext(none));
+
+            expect(first.source == MidiCaptureFormat::Source::device);
+            expectEquals(first.deviceSlot, 2);
+            expectEquals(first.message.getControllerValue(), 32);
+
+            expect(second.source == MidiCaptureFormat::Source::host);
+            expectEquals(second.samplePosition, 17);
+            expectEquals(second.message.getControllerValue(), 96);
+
+            expect(third.source == MidiCaptureFormat::Source::device);
+            expectEquals(third.message.getControllerValue(), 127);
+            expectGreaterOrEqual(third.timeSeconds - first.timeSeconds, 2.0 * kGapMs * 0.001);
+        }
+
+        beginTest("Offline replay drives the gain through processBlock");
+        {
+            Test_filterAudioProcessor processor(false);
+            processor.setRateAndBufferSizeDetails(kSampleRate, kBlockSize);
+            processor.prepareToPlay(kSampleRate, kBlockSize);
+
+            const int gainIndex = processor.getParameters().getParameter("gain")->getParameterIndex();
+
+            const auto start = juce::Time::getMillisecondCounterHiRes();
+            expectEquals(processor.getCapturePlayer().renderOffline(capture.getFile(), processor), 3);
+            const auto elapsedMs = juce::Time::getMillisecondCounterHiRes() - start;
+
+            // The recording spans two gaps; offline doesn't wait them out
+            expectLessThan(elapsedMs, 2.0 * kGapMs);
+            expectWithinAbsoluteError(processor.getParameterBridge().getDspValue(gainIndex), 1.0f, 1.0e-6f);
+
+            // The gain history shows the last move at its recorded time, in samples
+            const auto points = processor.getGainHistory().getPoints();
+            expect(! points.empty());
+            expect(points.back().source == AutomationHistory::Source::midi);
+            expectGreaterOrEqual(points.back().timeSeconds, 2.0 * kGapMs * 0.001);
+
+            expectEquals(processor.getCapturePlayer().renderOffline(juce::File(), processor), -1);
+            processor.releaseResources();
+        }
+    }
+
+private:
+    static constexpr int kGapMs = 50;
+    static constexpr double kSampleRate = 48000.0;
+    static constexpr int kBlockSize = 256;
+};
+
+static MidiCaptureTests midiCaptureTests;
@@ -0,0 +1,135 @@
+/*
+  ==============================================================================
+
+    MidiDispatchBenchmarks.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/PluginProcessor.h"
+
+//==============================================================================
+// Pushes synthetic MIDI through the processor's whole control path: parsing,
+// mapping, coalescing, parameter bridge and gain smoothing in processBlock,
+// then publishing to the host and listeners as the bridge's timer would.
+//
+// The processor has no control sources, so no device, group or daemon
+// traffic lands in the timings. Each density is a stream of 14-bit CC 7/39
+// pairs spread over the block, from 1 to 10,000 events per block. Run with
+// the "Benchmarks" category.
+class MidiDispatchBenchmarks : public juce::UnitTest
+{
+public:
+    MidiDispatchBenchmarks() : juce::UnitTest("MIDI dispatch through processBlock", "Benchmarks") {}
+
+    void runTest() override
+    {
+        Test_filterAudioProcessor processor(false);
+        processor.setRateAndBufferSizeDetails(kSampleRate, kBlockSize);
+        processor.prepareToPlay(kSampleRate, kBlockSize);
+
+        for (const int density : { 1, 10, 100, 1000, 10000 })
+        {
+            beginTest(juce::String(density) + " events per block");
+
+            const auto result = run(processor, density);
+
+            logMessage("events/s " + juce::String(result.eventsPerSecond, 0)
+                       + "   us/block mean " + juce::String(result.meanBlockMicros, 2)
+                       + "   worst " + juce::String(result.worstBlockMicros, 2));
+            logMessage("us publishing mean " + juce::String(result.meanPublishMicros, 2)
+                       + "   worst " + juce::String(result.worstPublishMicros, 2));
+
+            expect(result.eventsPerSecond > 0.0);
+            expect(std::isfinite(checksum));
+        }
+
+        processor.releaseResources();
+    }
+
+private:
+    static constexpr double kSampleRate = 48000.0;
+    static constexpr int kBlockSize = 512;
+    static constexpr int kNumBlocks = 200;
+    static constexpr int kWarmUpBlocks = 8;
+
+    struct Result
+    {
+        double eventsPerSecond = 0.0;   // through processBlock
+        double meanBlockMicros = 0.0, worstBlockMicros = 0.0;
+        double meanPublishMicros = 0.0, worstPublishMicros = 0.0; // host/listener notification after each block
+    };
+
+    Result run(Test_filterAudioProcessor& processor, int density)
+    {
+        // A few different streams so values keep changing; built up front,
+        // copied outside the timed part
+        std::array<juce::MidiBuffer, 4> streams;
+        for (size_t i = 0; i < streams.size(); ++i)
+            streams[i] = makeStream(density, (int) i);
+
+        juce::AudioBuffer<float> audio(processor.getTotalNumInputChannels(), kBlockSize);
+        juce::MidiBuffer midi;
+        juce::int64 totalTicks = 0, worstTicks = 0, totalPublishTicks = 0, worstPublishTicks = 0;
+
+        for (int block = -kWarmUpBlocks; block < kNumBlocks; ++block)
+        {
+            midi = streams[(size_t) (block + kWarmUpBlocks) % streams.size()];
+            audio.clear();
+
+            const auto start = juce::Time::getHighResolutionTicks();
+            processor.processBlock(audio, midi);
+            const auto processed = juce::Time::getHighResolutionTicks();
+            processor.getParameterBridge().publishPending();
+            const auto published = juce::Time::getHighResolutionTicks();
+
+            checksum += (double) audio.getMagnitude(0, kBlockSize);
+
+            if (block < 0)
+                continue;
+
+            totalTicks += processed - start;
+            worstTicks = juce::jmax(worstTicks, processed - start);
+            totalPublishTicks += published - processed;
+            worstPublishTicks = juce::jmax(worstPublishTicks, published - processed);
+        }
+
+        const double totalMicros = ticksToMicros(totalTicks);
+
+        Result result;
+        result.eventsPerSecond = totalMicros > 0.0 ? (double) density * kNumBlocks / (totalMicros * 1.0e-6) : 0.0;
+        result.meanBlockMicros = totalMicros / kNumBlocks;
+        result.worstBlockMicros = ticksToMicros(worstTicks);
+        result.meanPublishMicros = ticksToMicros(totalPublishTicks) / kNumBlocks;
+        result.worstPublishMicros = ticksToMicros(worstPublishTicks);
+        return result;
+    }
+
+    // 14-bit gain moves, MSB then LSB, so every event goes through the parser
+    static juce::MidiBuffer makeStream(int numEvents, int seed)
+    {
+        juce::MidiBuffer buffer;
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            const int value = (seed * 131 + i * 7) & 0x3fff;
+            const int samplePosition = (int) ((juce::int64) i * kBlockSize / numEvents);
+
+            buffer.addEvent(i % 2 == 0 ? juce::MidiMessage::controllerEvent(1, 7, value >> 7)
+                                       : juce::MidiMessage::controllerEvent(1, 39, value & 0x7f),
+                            samplePosition);
+        }
+
+        return buffer;
+    }
+
+    static double ticksToMicros(juce::int64 ticks)
+    {
+        return juce::Time::highResolutionTicksToSeconds(ticks) * 1.0e6;
+    }
+
+    double checksum = 0.0;
+};
+
+static MidiDispatchBenchmarks midiDispatchBenchmarks;
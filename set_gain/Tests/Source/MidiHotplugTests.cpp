@@ -0,0 +1,143 @@
+/*
+  ==============================================================================
+
+    MidiHotplugTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/MidiDeviceService.h"
+
+//==============================================================================
+// Drives MidiDeviceService from virtual ports instead of a controller: each
+// cycle creates a port (ALSA sequencer or CoreMIDI), waits for the service to
+// open it, sends a CC burst with jittered spacing, then removes the port and
+// waits for the service to close it. Reports reconnection latency, messages
+// lost and the time the MIDI thread spends delivering.
+//
+// Needs a system MIDI service but no hardware; run with the "Hotplug" category.
+class MidiHotplugTests : public juce::UnitTest,
+                         private MidiDeviceService::Callback
+{
+public:
+    MidiHotplugTests() : juce::UnitTest("MIDI device hotplug", "Hotplug") {}
+
+    void runTest() override
+    {
+        juce::SharedResourcePointer<MidiDeviceService> service;
+        service->addCallback(this);
+        service->resetStats();
+
+        beginTest("Virtual device appear/disappear cycles with CC bursts");
+
+        double latencyTotalMs = 0.0, latencyMaxMs = 0.0;
+        int numLost = 0, numCycles = 0;
+
+        for (int cycle = 0; cycle < kNumCycles; ++cycle)
+        {
+            const auto name = "SetGainTests hotplug " + juce::String(cycle);
+            const int openBefore = service->getNumOpenDevices();
+            const double createdMs = juce::Time::getMillisecondCounterHiRes();
+
+            auto port = juce::MidiOutput::createNewDevice(name);
+            if (port == nullptr)
+            {
+                logMessage("Virtual MIDI ports aren't available here, skipped");
+                break;
+            }
+
+            expect(dispatchUntil([&] { return service->getNumOpenDevices() > openBefore; }), "device not opened");
+
+            const double latencyMs = service->getStats().lastDeviceOpenedMs - createdMs;
+            latencyTotalMs += latencyMs;
+            latencyMaxMs = juce::jmax(latencyMaxMs, latencyMs);
+
+            slot = findSlot(*service, name);
+            expect(slot >= 0, "virtual device has no slot");
+
+            numReceived = 0;
+            sendBurst(*port);
+
+            dispatchUntil([this] { return numReceived.load() >= kBurstSize; });
+            numLost += kBurstSize - numReceived.load();
+
+            slot = -1;
+            port.reset();
+            expect(dispatchUntil([&] { return service->getNumOpenDevices() == openBefore; }), "device not closed");
+
+            ++numCycles;
+        }
+
+        service->removeCallback(this);
+
+        if (numCycles == 0)
+            return;
+
+        const auto stats = service->getStats();
+
+        logMessage("cycles " + juce::String(numCycles)
+                   + "   reconnect ms mean " + juce::String(latencyTotalMs / numCycles, 1)
+                   + " max " + juce::String(latencyMaxMs, 1));
+        logMessage("messages sent " + juce::String(numCycles * kBurstSize) + "   lost " + juce::String(numLost));
+        logMessage("delivery us mean " + juce::String(stats.callbackMicrosTotal / juce::jmax((juce::int64) 1, stats.numMessages), 2)
+                   + " max " + juce::String(stats.callbackMicrosMax, 2));
+
+        expectEquals(numLost, 0, "messages lost");
+    }
+
+private:
+    static constexpr int kNumCycles = 20;
+    static constexpr int kBurstSize = 500;
+    static constexpr int kTimeoutMs = 3000;
+
+    void handleDeviceMidi(int deviceSlot, const juce::MidiMessage& message) override
+    {
+        if (deviceSlot == slot.load() && message.isController())
+            ++numReceived;
+    }
+
+    // A knob turned quickly: about 1000 CCs a second, with the gaps of a
+    // controller scanning its inputs, 0-2 ms apart
+    void sendBurst(juce::MidiOutput& port)
+    {
+        auto random = getRandom();
+
+        for (int i = 0; i < kBurstSize; ++i)
+        {
+            port.sendMessageNow(juce::MidiMessage::controllerEvent(1, 7, i % 128));
+            juce::Thread::sleep(random.nextInt(3));
+        }
+    }
+
+    // Hotplug is handled on the message thread, so keep it running while waiting
+    template <typename Condition>
+    static bool dispatchUntil(Condition condition)
+    {
+        const auto endMs = juce::Time::getMillisecondCounter() + (juce::uint32) kTimeoutMs;
+
+        while (! condition())
+        {
+            if (juce::Time::getMillisecondCounter() >= endMs)
+                return false;
+
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+        }
+
+        return true;
+    }
+
+    static int findSlot(const MidiDeviceService& service, const juce::String& name)
+    {
+        for (int i = 0; i < MidiDeviceService::kMaxDevices; ++i)
+            if (service.getDeviceInfo(i).name == name)
+                return i;
+
+        return -1;
+    }
+
+    std::atomic<int> slot { -1 };
+    std::atomic<int> numReceived { 0 };
+};
+
+static MidiHotplugTests midiHotplugTests;
@@ -0,0 +1,232 @@
+/*
+  ==============================================================================
+
+    OscControlReceiverTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/OscControlReceiver.h"
+
+//==============================================================================
+// Binds the receiver on a free local port and sends it OSC from a plain
+// DatagramSocket: an exact address, a pattern, a bundle, addresses it
+// doesn't know, and more changes than its FIFO holds.
+class OscControlReceiverTests : public juce::UnitTest
+{
+public:
+    OscControlReceiverTests() : juce::UnitTest("OscControlReceiver", "OSC") {}
+
+    void runTest() override
+    {
+        TwoParameterProcessor processor;
+        OscControlReceiver receiver(processor);
+        juce::DatagramSocket sender(false);
+
+        const int gainIndex = processor.parameters.getParameter("gain")->getParameterIndex();
+        const int mixIndex = processor.parameters.getParameter("mix")->getParameterIndex();
+
+        beginTest("Binds to a free port");
+        {
+            int port = kFirstPort;
+            while (! receiver.setPort(port) && port < kFirstPort + 100)
+                ++port;
+
+            expect(receiver.isListening());
+            expectEquals(receiver.getPort(), port);
+        }
+
+        const auto send = [&](const juce::MemoryBlock& packet)
+        {
+            expectEquals(sender.write("127.0.0.1", receiver.getPort(), packet.getData(), (int) packet.getSize()), (int) packet.getSize());
+        };
+
+        beginTest("Exact address");
+        {
+            send(message("/set_gain/gain", 0.25f));
+            waitForTotal(receiver, 1);
+
+            expectChanges(receiver, { { gainIndex, 0.25f } });
+            expectStats(receiver, 1, 0, 0);
+        }
+
+        beginTest("Pattern address matches every parameter it covers");
+        {
+            send(message("/set_gain/*", 0.75f));
+            waitForTotal(receiver, 3);
+
+            auto changes = drain(receiver);
+            std::sort(changes.begin(), changes.end());
+            expect(changes == std::vector<std::pair<int, float>> { { juce::jmin(gainIndex, mixIndex), 0.75f },
+                                                                   { juce::jmax(gainIndex, mixIndex), 0.75f } });
+            expectStats(receiver, 3, 0, 0);
+        }
+
+        beginTest("Bundle elements, with an unknown address among them");
+        {
+            send(bundle({ message("/set_gain/mix", 0.5f), message("/set_gain/nothing", 1.0f), message("/set_gain/gain", 2.0f) }));
+            waitForTotal(receiver, 6);
+
+            // Values are clamped to 0-1
+            expectChanges(receiver, { { mixIndex, 0.5f }, { gainIndex, 1.0f } });
+            expectStats(receiver, 5, 1, 0);
+        }
+
+        beginTest("Unmatched patterns and missing arguments");
+        {
+            send(message("/other/*", 0.5f));
+            send(addressOnly("/set_gain/gain"));
+            waitForTotal(receiver, 8);
+
+            expectChanges(receiver, {});
+            expectStats(receiver, 5, 3, 0);
+        }
+
+        beginTest("Changes beyond the FIFO's capacity are dropped and counted");
+        {
+            constexpr int kPerBundle = 40;
+            const int numBundles = OscControlReceiver::kCapacity / kPerBundle + 2;
+            const int numSent = numBundles * kPerBundle;
+
+            for (int i = 0; i < numBundles; ++i)
+            {
+                std::vector<juce::MemoryBlock> elements;
+                for (int j = 0; j < kPerBundle; ++j)
+                    elements.push_back(message("/set_gain/gain", (float) j / kPerBundle));
+
+                send(bundle(elements));
+            }
+
+            waitForTotal(receiver, 8 + numSent);
+
+            expectEquals((int) drain(receiver).size(), OscControlReceiver::kCapacity);
+            expectStats(receiver, 5 + OscControlReceiver::kCapacity, 3, numSent - OscControlReceiver::kCapacity);
+        }
+
+        beginTest("Port 0 turns it off");
+        {
+            expect(receiver.setPort(0));
+            expect(! receiver.isListening());
+        }
+    }
+
+private:
+    static constexpr int kFirstPort = 19001;
+
+    // Just enough of a plugin to own two parameters
+    class TwoParameterProcessor : public juce::AudioProcessor
+    {
+    public:
+        TwoParameterProcessor()
+            : parameters(*this, nullptr, "PARAMETERS",
+                         { std::make_unique<juce::AudioParameterFloat>("gain", "Gain", 0.0f, 1.0f, 0.5f),
+                           std::make_unique<juce::AudioParameterFloat>("mix", "Mix", 0.0f, 1.0f, 1.0f) })
+        {
+        }
+
+        const juce::String getName() const override { return "OSC test"; }
+        void prepareToPlay(double, int) override {}
+        void releaseResources() override {}
+        void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+        double getTailLengthSeconds() const override { return 0.0; }
+        bool acceptsMidi() const override { return false; }
+        bool producesMidi() const override { return false; }
+        juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+        bool hasEditor() const override { return false; }
+        int getNumPrograms() override { return 1; }
+        int getCurrentProgram() override { return 0; }
+        void setCurrentProgram(int) override {}
+        const juce::String getProgramName(int) override { return {}; }
+        void changeProgramName(int, const juce::String&) override {}
+        void getStateInformation(juce::MemoryBlock&) override {}
+        void setStateInformation(const void*, int) override {}
+
+        juce::AudioProcessorValueTreeState parameters;
+    };
+
+    //==============================================================================
+    // OSC 1.0 encoding: strings NUL-terminated and padded to 4 bytes, numbers big-endian
+    static void writeString(juce::MemoryOutputStream& out, const char* text)
+    {
+        const auto length = std::strlen(text);
+        out.write(text, length);
+
+        for (size_t i = length; i < ((length + 4) & ~(size_t) 3); ++i)
+            out.writeByte(0);
+    }
+
+    static juce::MemoryBlock message(const char* address, float value)
+    {
+        juce::MemoryOutputStream out;
+        writeString(out, address);
+        writeString(out, ",f");
+
+        juce::uint32 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        out.writeIntBigEndian((int) bits);
+        return out.getMemoryBlock();
+    }
+
+    static juce::MemoryBlock addressOnly(const char* address)
+    {
+        juce::MemoryOutputStream out;
+        writeString(out, address);
+        writeString(out, ",");
+        return out.getMemoryBlock();
+    }
+
+    static juce::MemoryBlock bundle(const std::vector<juce::MemoryBlock>& elements)
+    {
+        juce::MemoryOutputStream out;
+        writeString(out, "#bundle");
+        out.writeInt64BigEndian(1);   // "immediately"
+
+        for (const auto& element : elements)
+        {
+            out.writeIntBigEndian((int) element.getSize());
+            out.write(element.getData(), element.getSize());
+        }
+
+        return out.getMemoryBlock();
+    }
+
+    //==============================================================================
+    // The receiver runs on its own thread; wait until it has handled this
+    // many changes in total, matched, unmatched or dropped
+    static void waitForTotal(const OscControlReceiver& receiver, int total)
+    {
+        for (int i = 0; i < 200; ++i)
+        {
+            const auto stats = receiver.getStats();
+            if ((int) (stats.numMessages + stats.numUnmatched + stats.numDropped) >= total)
+                return;
+
+            juce::Thread::sleep(5);
+        }
+    }
+
+    static std::vector<std::pair<int, float>> drain(OscControlReceiver& receiver)
+    {
+        std::vector<std::pair<int, float>> changes;
+        receiver.forEachChange([&changes](int parameterIndex, float value) { changes.emplace_back(parameterIndex, value); });
+        return changes;
+    }
+
+    void expectChanges(OscControlReceiver& receiver, const std::vector<std::pair<int, float>>& expected)
+    {
+        const auto changes = drain(receiver);
+        expect(changes == expected, "got " + juce::String((int) changes.size()) + " changes, expected "
+                                    + juce::String((int) expected.size()));
+    }
+
+    void expectStats(const OscControlReceiver& receiver, int numMessages, int numUnmatched, int numDropped)
+    {
+        const auto stats = receiver.getStats();
+        expectEquals((int) stats.numMessages, numMessages);
+        expectEquals((int) stats.numUnmatched, numUnmatched);
+        expectEquals((int) stats.numDropped, numDropped);
+    }
+};
+
+static OscControlReceiverTests oscControlReceiverTests;
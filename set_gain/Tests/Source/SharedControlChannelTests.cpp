@@ -0,0 +1,120 @@
+/*
+  ==============================================================================
+
+    SharedControlChannelTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/SharedControlChannel.h"
+
+#if JUCE_MAC || JUCE_LINUX
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <unistd.h>
+
+//==============================================================================
+// Plays the daemon with a SharedControlWriter in this process: the reader
+// connects on a fresh heartbeat, sees published values, drops the daemon
+// when the heartbeat stops, and a clean close unlinks the segment.
+//
+// Uses the real segment name, so it's skipped while a daemon is running.
+class SharedControlChannelTests : public juce::UnitTest,
+                                  private juce::ChangeListener
+{
+public:
+    SharedControlChannelTests() : juce::UnitTest("SharedControlChannel", "SharedControl") {}
+
+    void runTest() override
+    {
+        {
+            SharedControlReader probe;
+            if (probe.isConnected())
+            {
+                logMessage("A control daemon is running, skipped");
+                return;
+            }
+        }
+
+        SharedControlWriter writer;
+
+        beginTest("Connects to a live heartbeat");
+        expect(writer.open());
+
+        SharedControlReader reader;
+        reader.addChangeListener(this);
+        expect(dispatchUntil([&] { return reader.isConnected(); }), "not connected");
+
+        beginTest("Values reach the reader once");
+        {
+            writer.publish(0, 0.25f);
+            writer.publish(1, 2.0f);
+
+            juce::Array<std::pair<int, float>> changes;
+            reader.forEachChange([&](int index, float value) { changes.add({ index, value }); });
+
+            expectEquals(changes.size(), 2);
+            expect(changes[0] == std::make_pair(0, 0.25f));
+            expect(changes[1] == std::make_pair(1, 1.0f), "not clamped");
+
+            int numRepeated = 0;
+            reader.forEachChange([&](int, float) { ++numRepeated; });
+            expectEquals(numRepeated, 0);
+        }
+
+        beginTest("A stopped heartbeat disconnects, a new beat reconnects");
+        {
+            numChanges = 0;
+            expect(dispatchUntil([&] { return ! reader.isConnected(); }), "still connected without a heartbeat");
+            expectEquals(numChanges, 1);
+
+            writer.beat();
+            expect(dispatchUntil([&] { return reader.isConnected(); }), "not reconnected");
+            expectEquals(numChanges, 2);
+        }
+
+        beginTest("A clean close unlinks the segment and disconnects at once");
+        {
+            writer.close();
+
+            const int fd = shm_open(SharedControl::kSegmentName, O_RDONLY, 0);
+            expect(fd < 0, "segment left behind");
+            if (fd >= 0)
+                ::close(fd);
+
+            expect(dispatchUntil([&] { return ! reader.isConnected(); }, 1500), "still connected after close");
+        }
+
+        reader.removeChangeListener(this);
+    }
+
+private:
+    void changeListenerCallback(juce::ChangeBroadcaster*) override
+    {
+        ++numChanges;
+    }
+
+    // The reader checks on the message thread, so keep it running while waiting
+    template <typename Condition>
+    static bool dispatchUntil(Condition condition, int timeoutMs = (int) SharedControl::kHeartbeatTimeoutMs + 2000)
+    {
+        const auto endMs = juce::Time::getMillisecondCounter() + (juce::uint32) timeoutMs;
+
+        while (! condition())
+        {
+            if (juce::Time::getMillisecondCounter() >= endMs)
+                return false;
+
+            juce::MessageManager::getInstance()->runDispatchLoopUntil(5);
+        }
+
+        return true;
+    }
+
+    int numChanges = 0;
+};
+
+static SharedControlChannelTests sharedControlChannelTests;
+
+#endif
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    UmpControllerDecoderTests.cpp
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../Source/MidiGainController.h"
+#include "../../Source/ParameterBridge.h"
+
+//==============================================================================
+// Feeds device slots MIDI 2.0 controller packets and byte-stream MIDI, and
+// follows the value through the learn table and the ParameterBridge to the
+// gain parameter, as processBlock would.
+class UmpControllerDecoderTests : public juce::UnitTest
+{
+public:
+    UmpControllerDecoderTests() : juce::UnitTest("UmpControllerDecoder", "MIDI") {}
+
+    void runTest() override
+    {
+        GainProcessor processor;
+        MidiGainController controller(processor.parameters, nullptr);
+        auto* gain = processor.parameters.getParameter("gain");
+
+        beginTest("32-bit CC keeps its full resolution up to the parameter");
+        {
+            // Halfway between two 14-bit steps, so any 14-bit stage would show
+            const auto value = (juce::uint32) (8192.5 / 16383.0 * (double) 0xffffffffu);
+            const auto expected = (float) ((double) value / (double) 0xffffffffu);
+
+            const juce::uint32 packet[2] = { midi2Controller(1, 7), value };
+            expectMapped(controller, processor, packet, expected);
+            expectWithinAbsoluteError(gain->getValue(), expected, kTolerance);
+        }
+
+        beginTest("Controllers on other channels and groups");
+        {
+            const juce::uint32 packet[2] = { midi2Controller(16, 7) | (3u << 24), 0xffffffffu };
+            expectMapped(controller, processor, packet, 1.0f);
+
+            // Unmapped controller
+            const juce::uint32 unmapped[2] = { midi2Controller(1, 74), 0x40000000u };
+            int parameterIndex = -1;
+            float normalisedValue = 0.0f;
+            expect(! controller.mapDevicePacket(0, unmapped, parameterIndex, normalisedValue));
+        }
+
+        beginTest("Byte-stream device MIDI goes through as MIDI 1.0 packets");
+        {
+            int parameterIndex = -1;
+            float normalisedValue = 0.0f;
+
+            expect(controller.mapDeviceMessage(1, juce::MidiMessage::controllerEvent(1, 7, 100), parameterIndex, normalisedValue));
+            expect(controller.mapDeviceMessage(1, juce::MidiMessage::controllerEvent(1, 39, 5), parameterIndex, normalisedValue));
+            expectEquals(parameterIndex, gain->getParameterIndex());
+            expectWithinAbsoluteError(normalisedValue, (float) ((100 << 7) | 5) / 16383.0f, kTolerance);
+
+            // Nothing but channel voice messages is mapped
+            expect(! controller.mapDeviceMessage(1, juce::MidiMessage::midiClock(), parameterIndex, normalisedValue));
+        }
+    }
+
+private:
+    static constexpr float kTolerance = 1.0e-7f;
+
+    // Just enough of a plugin to own the parameter and the bridge
+    class GainProcessor : public juce::AudioProcessor
+    {
+    public:
+        GainProcessor()
+            : parameters(*this, nullptr, "PARAMETERS",
+                         { std::make_unique<juce::AudioParameterFloat>("gain", "Gain", 0.0f, 1.0f, 0.5f) })
+        {
+        }
+
+        const juce::String getName() const override { return "UMP test"; }
+        void prepareToPlay(double, int) override {}
+        void releaseResources() override {}
+        void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override {}
+        double getTailLengthSeconds() const override { return 0.0; }
+        bool acceptsMidi() const override { return true; }
+        bool producesMidi() const override { return false; }
+        juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+        bool hasEditor() const override { return false; }
+        int getNumPrograms() override { return 1; }
+        int getCurrentProgram() override { return 0; }
+        void setCurrentProgram(int) override {}
+        const juce::String getProgramName(int) override { return {}; }
+        void changeProgramName(int, const juce::String&) override {}
+        void getStateInformation(juce::MemoryBlock&) override {}
+        void setStateInformation(const void*, int) override {}
+
+        juce::AudioProcessorValueTreeState parameters;
+        ParameterBridge bridge { *this };
+    };
+
+    // MIDI 2.0 channel voice control change, first word
+    static juce::uint32 midi2Controller(int channel, int controller)
+    {
+        return 0x40b00000u | ((juce::uint32) (channel - 1) << 16) | ((juce::uint32) controller << 8);
+    }
+
+    // Maps the packet on device slot 0, then passes the change to the
+    // parameter the way the processor and the bridge's timer do
+    void expectMapped(MidiGainController& controller, GainProcessor& processor, const juce::uint32* packet, float expected)
+    {
+        int parameterIndex = -1;
+        float normalisedValue = 0.0f;
+
+        expect(controller.mapDevicePacket(0, packet, parameterIndex, normalisedValue));
+        expectEquals(parameterIndex, processor.parameters.getParameter("gain")->getParameterIndex());
+        expectWithinAbsoluteError(normalisedValue, expected, kTolerance);
+
+        processor.bridge.push(parameterIndex, normalisedValue);
+        expectWithinAbsoluteError(processor.bridge.getDspValue(parameterIndex), expected, kTolerance);
+        processor.bridge.publishPending();
+    }
+};
+
+static UmpControllerDecoderTests umpControllerDecoderTests;